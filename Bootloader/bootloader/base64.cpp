@@ -0,0 +1,108 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "base64.h"
+
+#include <array>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr uint8_t InvalidCharacter = 0xff;
+
+    constexpr auto makeTable() -> std::array<uint8_t, 256>
+    {
+        std::array<uint8_t, 256> table = {};
+        table.fill(InvalidCharacter);
+
+        for (uint8_t i = 0; i < 26; ++i)
+        {
+            table['A' + i] = i;
+            table['a' + i] = 26 + i;
+        }
+
+        for (uint8_t i = 0; i < 10; ++i)
+            table['0' + i] = 52 + i;
+
+        table['+'] = 62;
+        table['/'] = 63;
+
+        return table;
+    }
+
+    constexpr std::array<uint8_t, 256> Table = makeTable();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Base64::decode(std::span<const char> string, std::span<uint8_t> output)
+    -> std::optional<size_t>
+{
+    if (string.size() % 4 != 0 || string.size() / 4 * 3 > output.size())
+        return std::nullopt;
+
+    size_t padding = 0;
+
+    while (padding < 2 && padding < string.size() && string[string.size() - 1 - padding] == '=')
+        ++padding;
+
+    uint8_t* bytes = output.data();
+    uint8_t invalid = 0;
+
+    for (size_t i = 0; i < string.size(); i += 4)
+    {
+        uint32_t word = 0;
+
+        for (size_t j = 0; j < 4; ++j)
+        {
+            // Padding decodes as zero, it's cut off below
+            const bool pad = (i + j >= string.size() - padding);
+            const uint8_t value = pad ? 0 : Table[static_cast<uint8_t>(string[i + j])];
+
+            invalid |= value;
+            word = (word << 6) | (value & 0x3f);
+        }
+
+        *bytes++ = static_cast<uint8_t>(word >> 16);
+        *bytes++ = static_cast<uint8_t>(word >> 8);
+        *bytes++ = static_cast<uint8_t>(word);
+    }
+
+    // Only invalid characters have the upper bits set
+    if (invalid & 0xc0)
+        return std::nullopt;
+
+    return static_cast<size_t>(bytes - output.data()) - padding;
+}
+
+// ---------------------------------------------------------------------------------------------- //
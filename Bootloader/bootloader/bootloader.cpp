@@ -40,6 +40,11 @@
 
 // ---------------------------------------------------------------------------------------------- //
 
+Bootloader::Bootloader(Owner* owner)
+    : m_owner(owner) {}
+
+// ---------------------------------------------------------------------------------------------- //
+
 auto Bootloader::info() const -> const Info&
 {
     return m_info;
@@ -49,21 +54,32 @@ auto Bootloader::info() const -> const Info&
 
 auto Bootloader::getFirmwareValid() const -> bool
 {
-    return BootManager::getFirmwareValid();
+    if (!m_firmwareValid)
+        m_firmwareValid = BootManager::getFirmwareValid();
+
+    return *m_firmwareValid;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
+// Starts over with a fresh programmer. One left unlocked by an abandoned upload would still
+// consider the sectors it erased as such, although they now hold part of that image.
 void Bootloader::unlockFirmware()
 {
-    if (!m_programmer)
-        m_programmer = new (m_programmerBuffer.data()) Programmer();
+    lockFirmware();
+    m_programmer = new (m_programmerBuffer.data()) Programmer(this);
+
+    m_decompressor.reset();
+    m_patcher.reset();
+    m_firmwareValid.reset();
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void Bootloader::lockFirmware()
 {
+    m_patcher.reset();
+
     if (m_programmer)
     {
         m_programmer->~Programmer();
@@ -78,26 +94,92 @@ void Bootloader::eraseSector(size_t sector)
     if (!m_programmer)
         throw Error(Error::Type::FirmwareLocked);
 
+    m_firmwareValid.reset();
     m_programmer->eraseSector(sector);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Bootloader::writeHexRecord(const char* string)
+void Bootloader::eraseSectors(size_t first, size_t count)
+{
+    if (!m_programmer)
+        throw Error(Error::Type::FirmwareLocked);
+
+    m_firmwareValid.reset();
+    m_programmer->eraseSectors(first, count);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Bootloader::writeHexRecord(std::span<const char> string)
 {
     if (!m_programmer)
         throw Error(Error::Type::FirmwareLocked);
 
     const auto record = HexRecord::fromString(string);
+
+    m_firmwareValid.reset();
     m_programmer->processRecord(record);
+
+    // Verify the new image right away, so that subsequent queries are answered from the cache
+    if (record.type() == HexRecord::Type::EndOfFile)
+    {
+        m_decompressor.reset();
+        m_firmwareValid = BootManager::getFirmwareValid();
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Bootloader::launchFirmware()
+void Bootloader::writeCompressedBlock(std::span<const char> string)
 {
-    lockFirmware();
-    BootManager::reboot(BootManager::Mode::Firmware);
+    if (!m_programmer)
+        throw Error(Error::Type::FirmwareLocked);
+
+    const Decompressor::Output output = m_decompressor.decompress(string);
+
+    m_firmwareValid.reset();
+    m_programmer->writeData(output.address, output.data.data(), output.data.size());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Bootloader::beginPatch(uint32_t sourceCrc, uint32_t targetLength, uint32_t targetCrc)
+{
+    if (!m_programmer)
+        throw Error(Error::Type::FirmwareLocked);
+
+    m_firmwareValid.reset();
+    m_patcher.begin(m_programmer, sourceCrc, { targetLength, targetCrc });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Bootloader::writePatchBlock(std::span<const char> block)
+{
+    if (!m_programmer)
+        throw Error(Error::Type::FirmwareLocked);
+
+    m_patcher.write(block);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Bootloader::finishPatch()
+{
+    if (!m_programmer)
+        throw Error(Error::Type::FirmwareLocked);
+
+    m_patcher.finish();
+    m_firmwareValid = BootManager::getFirmwareValid();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Bootloader::onSectorErase(size_t sector)
+{
+    if (m_owner)
+        m_owner->onSectorErase(sector);
 }
 
 // ---------------------------------------------------------------------------------------------- //
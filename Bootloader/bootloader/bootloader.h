@@ -34,12 +34,16 @@
 #pragma once
 
 #include "config.h"
+#include "decompressor.h"
+#include "patcher.h"
 #include "programmer.h"
 
 #include <array>
 #include <exception>
+#include <optional>
+#include <span>
 
-class Bootloader
+class Bootloader : private Programmer::Owner
 {
 public:
     struct Info
@@ -48,12 +52,24 @@ public:
         const char* hardwareVersion = Config::HardwareVersion;
         const char* bootloaderVersion = Config::BootloaderVersion;
         size_t sectorCount = Config::FirmwareSectorCount;
+        uint32_t firmwareStartAddress = Config::FirmwareStartAddress;
+        uint32_t firmwareEndAddress = Config::FirmwareEndAddress;
+        uint32_t wordSize = Programmer::wordSize();
+        size_t blockSize = Decompressor::MaximumLength;
+        const uint32_t* sectorSizes = &Config::FlashSectorSizes[Config::FirmwareStartSector]; // KiB
+        bool eraseOnWrite = true;
     };
 
     class Error;
 
+    class Owner
+    {
+        friend class Bootloader;
+        virtual void onSectorErase(size_t sector) = 0;
+    };
+
 public:
-    Bootloader() = default;
+    Bootloader(Owner* owner = nullptr);
     virtual ~Bootloader() = default;
 
     auto info() const -> const Info&;
@@ -64,14 +80,31 @@ public:
     void lockFirmware();
 
     void eraseSector(size_t sector);
-    void writeHexRecord(const char* record);
+    void eraseSectors(size_t first, size_t count);
+    void writeHexRecord(std::span<const char> record);
+    void writeCompressedBlock(std::span<const char> block);
 
-    void launchFirmware();
+    void beginPatch(uint32_t sourceCrc, uint32_t targetLength, uint32_t targetCrc);
+    void writePatchBlock(std::span<const char> block);
+    void finishPatch();
+
+private:
+    void onSectorErase(size_t sector) override;
 
 private:
-    std::array<char, sizeof(Programmer)> m_programmerBuffer;
+    Owner* m_owner;
+
+    alignas(Programmer) std::array<char, sizeof(Programmer)> m_programmerBuffer;
     Programmer* m_programmer = nullptr;
 
+    // Blocks reference data of the preceding ones, so the window is kept until the end of file
+    Decompressor m_decompressor;
+
+    Patcher m_patcher;
+
+    // Verified on first query, cleared whenever the firmware partition may change
+    mutable std::optional<bool> m_firmwareValid;
+
     Info m_info;
 };
 
@@ -34,6 +34,9 @@
 #include "bootmanager.h"
 #include "checksum.h"
 #include "config.h"
+#include "programmer.h"
+
+#include <exception>
 
 // ---------------------------------------------------------------------------------------------- //
 
@@ -46,6 +49,8 @@ namespace {
 
 void BootManager::init()
 {
+    installStagedFirmware(); // Also when the bootloader was requested, so it reports the result
+
     if (g_bootloaderMagic == BootloaderMagic) // Bootloader requested by application
         return;
 
@@ -65,12 +70,22 @@ void BootManager::init()
 
 auto BootManager::getFirmwareValid() -> bool
 {
-    const auto msp = *reinterpret_cast<uint32_t*>(Config::FirmwareStartAddress);
+    return getImageValid(Slot::Active);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto BootManager::getImageValid(const Slot& slot) -> bool
+{
+    if (!slot.enabled())
+        return false;
+
+    const auto msp = *reinterpret_cast<uint32_t*>(slot.startAddress);
 
     if (msp < Config::RamStartAddress || msp > Config::RamEndAddress)
         return false;
 
-    return Checksum::verify();
+    return Checksum::verify(slot);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -83,6 +98,29 @@ void BootManager::reboot(Mode mode)
 
 // ---------------------------------------------------------------------------------------------- //
 
+// A staged image is kept until it has been copied and verified, so an interrupted installation
+// is simply repeated on the next reset
+void BootManager::installStagedFirmware()
+{
+    if (!getImageValid(Slot::Staging))
+        return;
+
+    try {
+        const bool installed = getFirmwareValid() &&
+                               Checksum::read(Slot::Active) == Checksum::read(Slot::Staging);
+        if (!installed)
+            Programmer().copyImage(Slot::Staging);
+
+        if (getFirmwareValid())
+            Programmer(nullptr, Slot::Staging).invalidateImage();
+    }
+    catch (const std::exception&) {
+        // Leaves the partition invalid, so the bootloader stays active for a regular upload
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void boot_manager_init()
 {
     BootManager::init();
@@ -43,6 +43,8 @@ void boot_manager_init();
 #ifdef __cplusplus
 } // extern "C"
 
+#include "slot.h"
+
 class BootManager
 {
 public:
@@ -55,8 +57,12 @@ public:
     static void init();
 
     static auto getFirmwareValid() -> bool;
+    static auto getImageValid(const Slot& slot) -> bool;
 
     static void reboot(Mode mode);
+
+private:
+    static void installStagedFirmware();
 };
 
 #endif // __cplusplus
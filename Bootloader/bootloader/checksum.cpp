@@ -33,32 +33,43 @@
 
 #include "checksum.h"
 #include "config.h"
-#include "crc32.h"
+#include "crcengine.h"
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Checksum::compute() -> uint32_t
+auto Checksum::compute(const Slot& slot, uint32_t length) -> uint32_t
 {
     static constexpr uint32_t CrcInitializer = 0x00000000;
 
-    const auto buffer = reinterpret_cast<const uint8_t*>(Config::FirmwareStartAddress);
-    const uint32_t length = Config::FirmwareEndAddress - Config::FirmwareStartAddress;
-
-    return crc32_update_buffer(CrcInitializer, buffer, length);
+    const auto buffer = reinterpret_cast<const uint8_t*>(slot.startAddress);
+    return Crc32::update<Config::ChecksumEngine>(CrcInitializer, buffer, length);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Checksum::read() -> uint32_t
+auto Checksum::read(const Slot& slot) -> Record
 {
-    return *reinterpret_cast<uint32_t*>(Config::ChecksumAddress);
+    return *reinterpret_cast<const Record*>(slot.checksumAddress);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Checksum::verify() -> bool
+auto Checksum::verify(const Slot& slot) -> bool
 {
-    return compute() == read();
+    static constexpr uint32_t MinimumLength = 2 * sizeof(uint32_t); // Stack pointer and reset
+    static constexpr uint32_t MaximumLength = Config::FirmwareEndAddress -
+                                              Config::FirmwareStartAddress;
+
+    if (!slot.enabled())
+        return false;
+
+    const Record record = read(slot);
+
+    // Also rejects the erased state
+    if (record.length < MinimumLength || record.length > MaximumLength)
+        return false;
+
+    return compute(slot, record.length) == record.crc;
 }
 
 // ---------------------------------------------------------------------------------------------- //
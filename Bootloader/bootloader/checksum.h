@@ -33,12 +33,24 @@
 
 #pragma once
 
+#include "slot.h"
+
 #include <cstdint>
 
 class Checksum
 {
 public:
-    static auto compute() -> uint32_t;
-    static auto read() -> uint32_t;
-    static auto verify() -> bool;
+    // Stored at the end of a slot once an image has been programmed
+    struct Record
+    {
+        uint32_t length;
+        uint32_t crc;
+
+        auto operator==(const Record&) const -> bool = default;
+    };
+
+public:
+    static auto compute(const Slot& slot, uint32_t length) -> uint32_t;
+    static auto read(const Slot& slot) -> Record;
+    static auto verify(const Slot& slot) -> bool;
 };
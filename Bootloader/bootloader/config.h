@@ -33,6 +33,7 @@
 
 #pragma once
 
+#include "crcengine.h"
 #include "main.h"
 
 // IMPORTANT:
@@ -51,12 +52,38 @@ namespace Config {
     constexpr uint32_t RamStartAddress = 0x20000004; // 32 bits used for bootflags
     constexpr uint32_t RamEndAddress   = 0x20020000; // Adjust for actual SRAM size
 
+    constexpr uint32_t FlashBaseAddress = 0x08000000;
+    constexpr uint32_t FlashSectorSizes[] = { 16, 16, 16, 16, 64 }; // KiB, adjust for actual device
+
     constexpr uint32_t FirmwareStartSector = 2; // 2*16 KiB bootloader space, adjust if needed
     constexpr uint32_t FirmwareSectorCount = 3; // 2*16 KiB + 64 KiB, adjust for actual flash size
 
     constexpr uint32_t FirmwareStartAddress = 0x08008000; // Adjust according to memory map
-    constexpr uint32_t FirmwareEndAddress   = 0x08020000 - sizeof(uint32_t); // 32-bit CRC
+    constexpr uint32_t FirmwareEndAddress   = 0x08020000 - 2 * sizeof(uint32_t); // Length, CRC
 
     constexpr uint32_t ChecksumAddress = FirmwareEndAddress;
 
+    // Optional slot the running firmware writes new images to, installed by the bootloader on
+    // the next reset. Needs at least the size of the firmware partition, a sector count of 0
+    // disables staging.
+    constexpr uint32_t StagingStartSector = 0;
+    constexpr uint32_t StagingSectorCount = 0;
+
+    constexpr uint32_t StagingStartAddress = 0;
+    constexpr uint32_t StagingEndAddress   = 0;
+
+    // Optional sector holding a copy of each firmware sector while a delta update rewrites it
+    // in place. Must be at least as large as the largest firmware sector, 0 disables patching.
+    constexpr uint32_t ScratchSector  = 0;
+    constexpr uint32_t ScratchAddress = 0;
+
+    // Use Slicing4, Slicing8 or Bytewise on devices without a CRC unit, in order of decreasing
+    // speed and flash usage
+    constexpr CrcEngine ChecksumEngine = CrcEngine::Hardware;
+
+    // Longest request or response line, excluding its terminator. Sizes the host interface
+    // buffers and the longest hex record accepted. Larger frames allow longer records per
+    // request at the cost of RAM.
+    constexpr size_t MaximumFrameSize = 80;
+
 }
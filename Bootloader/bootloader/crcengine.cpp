@@ -0,0 +1,158 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+
+#include "crcengine.h"
+#include "crc32.h"
+#include "main.h"
+
+#include <array>
+#include <cstring>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    using SlicingTable = std::array<uint32_t, 256>;
+
+    // Table k advances a byte by k further zero bytes, so N bytes can be looked up at once
+    template <size_t N>
+    constexpr auto makeSlicingTables() -> std::array<SlicingTable, N>
+    {
+        std::array<SlicingTable, N> tables = {};
+
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLYNOM : crc >> 1;
+
+            tables[0][i] = crc;
+        }
+
+        for (size_t k = 1; k < N; ++k)
+        {
+            for (size_t i = 0; i < 256; ++i)
+                tables[k][i] = (tables[k-1][i] >> 8) ^ tables[0][tables[k-1][i] & 0xff];
+        }
+
+        return tables;
+    }
+
+    // Words are assembled little-endian, as on Cortex-M
+    inline auto readWord(const uint8_t* buffer) -> uint32_t
+    {
+        uint32_t word;
+        std::memcpy(&word, buffer, sizeof(word));
+        return word;
+    }
+
+    inline auto lookup(const SlicingTable& table, uint32_t word, int byte) -> uint32_t
+    {
+        return table[(word >> (8 * byte)) & 0xff];
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Crc32::updateBytewise(uint32_t crc, const uint8_t* buffer, uint32_t length) -> uint32_t
+{
+    return crc32_update_buffer(crc, buffer, length);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Crc32::updateSlicing4(uint32_t crc, const uint8_t* buffer, uint32_t length) -> uint32_t
+{
+    static constexpr auto Tables = makeSlicingTables<4>();
+
+    for (; length >= 4; buffer += 4, length -= 4)
+    {
+        const uint32_t word = readWord(buffer) ^ crc;
+
+        crc = lookup(Tables[3], word, 0) ^ lookup(Tables[2], word, 1) ^
+              lookup(Tables[1], word, 2) ^ lookup(Tables[0], word, 3);
+    }
+
+    return crc32_update_buffer(crc, buffer, length);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Crc32::updateSlicing8(uint32_t crc, const uint8_t* buffer, uint32_t length) -> uint32_t
+{
+    static constexpr auto Tables = makeSlicingTables<8>();
+
+    for (; length >= 8; buffer += 8, length -= 8)
+    {
+        const uint32_t low = readWord(buffer) ^ crc;
+        const uint32_t high = readWord(buffer + 4);
+
+        crc = lookup(Tables[7], low, 0) ^ lookup(Tables[6], low, 1) ^
+              lookup(Tables[5], low, 2) ^ lookup(Tables[4], low, 3) ^
+              lookup(Tables[3], high, 0) ^ lookup(Tables[2], high, 1) ^
+              lookup(Tables[1], high, 2) ^ lookup(Tables[0], high, 3);
+    }
+
+    return crc32_update_buffer(crc, buffer, length);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Crc32::updateHardware(uint32_t crc, const uint8_t* buffer, uint32_t length) -> uint32_t
+{
+    const uint32_t wordCount = length / sizeof(uint32_t);
+
+    if (wordCount == 0)
+        return crc32_update_buffer(crc, buffer, length);
+
+    __HAL_RCC_CRC_CLK_ENABLE();
+
+    // The unit shifts MSB-first with the non-reflected polynomial and always resets to 0xffffffff.
+    // Feeding that value back in clears the register, and reversing the bits of every word on the
+    // way in and out then yields the reflected CRC. The initial value enters with the first word.
+    CRC->CR = CRC_CR_RESET;
+    CRC->DR = 0xffffffff;
+
+    CRC->DR = __RBIT(readWord(buffer) ^ crc);
+
+    for (uint32_t i = 1; i < wordCount; ++i)
+        CRC->DR = __RBIT(readWord(buffer + i * sizeof(uint32_t)));
+
+    crc = __RBIT(CRC->DR);
+
+    const uint32_t processed = wordCount * sizeof(uint32_t);
+    return crc32_update_buffer(crc, buffer + processed, length - processed);
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,68 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+
+#pragma once
+
+#include <cstdint>
+
+// All engines compute the same CRC as crc32_update_buffer, so the stored checksum doesn't depend
+// on the engine the bootloader was built with. Slicing trades flash for speed, using 4 KiB of
+// tables for Slicing4 and 8 KiB for Slicing8. Hardware uses the CRC unit of the STM32.
+enum class CrcEngine
+{
+    Bytewise,
+    Slicing4,
+    Slicing8,
+    Hardware
+};
+
+namespace Crc32 {
+    auto updateBytewise(uint32_t crc, const uint8_t* buffer, uint32_t length) -> uint32_t;
+    auto updateSlicing4(uint32_t crc, const uint8_t* buffer, uint32_t length) -> uint32_t;
+    auto updateSlicing8(uint32_t crc, const uint8_t* buffer, uint32_t length) -> uint32_t;
+    auto updateHardware(uint32_t crc, const uint8_t* buffer, uint32_t length) -> uint32_t;
+
+    template <CrcEngine Engine>
+    inline auto update(uint32_t crc, const uint8_t* buffer, uint32_t length) -> uint32_t
+    {
+        if constexpr (Engine == CrcEngine::Slicing4)
+            return updateSlicing4(crc, buffer, length);
+        else if constexpr (Engine == CrcEngine::Slicing8)
+            return updateSlicing8(crc, buffer, length);
+        else if constexpr (Engine == CrcEngine::Hardware)
+            return updateHardware(crc, buffer, length);
+        else
+            return updateBytewise(crc, buffer, length);
+    }
+}
@@ -0,0 +1,195 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "base64.h"
+#include "config.h"
+#include "crcengine.h"
+#include "decompressor.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    inline auto readLittleEndian(const uint8_t* bytes, size_t count) -> uint32_t
+    {
+        uint32_t value = 0;
+
+        for (size_t i = 0; i < count; ++i)
+            value |= static_cast<uint32_t>(bytes[i]) << (i*8);
+
+        return value;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Decompressor::reset()
+{
+    m_windowLength = 0;
+    m_outputLength = 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Decompressor::decompress(std::span<const char> string) -> Output
+{
+    // Move the previous block into the window, which only keeps the most recent bytes
+    if (m_outputLength > 0)
+    {
+        const size_t total = m_windowLength + m_outputLength;
+        const size_t keep = std::min(total, WindowSize);
+
+        std::memmove(m_buffer.data(), m_buffer.data() + total - keep, keep);
+
+        m_windowLength = keep;
+        m_outputLength = 0;
+    }
+
+    const std::span<const uint8_t> block = decode(string);
+
+    if (block.size() < HeaderSize)
+        throw Error(Error::Type::InvalidBlock);
+
+    const uint32_t address = readLittleEndian(&block[0], 4);
+    const uint32_t length = readLittleEndian(&block[4], 2);
+    const uint32_t crc = readLittleEndian(&block[6], 4);
+
+    if (length > MaximumLength)
+        throw Error(Error::Type::InvalidLength);
+
+    uint8_t* output = m_buffer.data() + m_windowLength;
+    expand(block.subspan(HeaderSize), output, length);
+
+    const uint32_t headerCrc = Crc32::update<Config::ChecksumEngine>(0, block.data(), 6);
+
+    if (Crc32::update<Config::ChecksumEngine>(headerCrc, output, length) != crc)
+        throw Error(Error::Type::InvalidChecksum);
+
+    m_outputLength = length;
+
+    return { address, { output, length } };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Decompressor::decode(std::span<const char> string) -> std::span<const uint8_t>
+{
+    const std::optional<size_t> length = Base64::decode(string, m_block);
+
+    if (!length)
+        throw Error(Error::Type::InvalidBlock);
+
+    return { m_block.data(), *length };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Matches are bounds checked, so corrupted data can't reach outside the buffer before the
+// checksum rejects it
+void Decompressor::expand(std::span<const uint8_t> data, uint8_t* output, size_t length) const
+{
+    const uint8_t* input = data.data();
+    const uint8_t* const end = input + data.size();
+
+    size_t position = 0;
+
+    while (position < length)
+    {
+        if (input == end)
+            throw Error(Error::Type::InvalidData);
+
+        uint8_t flags = *input++;
+
+        for (size_t item = 0; item < 8 && position < length; ++item, flags >>= 1)
+        {
+            if (flags & 1)
+            {
+                if (input == end)
+                    throw Error(Error::Type::InvalidData);
+
+                output[position++] = *input++;
+                continue;
+            }
+
+            if (end - input < 2)
+                throw Error(Error::Type::InvalidData);
+
+            const uint16_t match = static_cast<uint16_t>((input[0] << 8) | input[1]);
+            input += 2;
+
+            const size_t distance = (match >> 6) + 1;
+            const size_t count = (match & 0x3f) + 3;
+
+            if (distance > m_windowLength + position || count > length - position)
+                throw Error(Error::Type::InvalidData);
+
+            // Byte by byte, as overlapping matches repeat the most recent bytes
+            const uint8_t* source = output + position - distance;
+
+            for (size_t i = 0; i < count; ++i)
+                output[position + i] = source[i];
+
+            position += count;
+        }
+    }
+
+    if (input != end)
+        throw Error(Error::Type::InvalidData);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Decompressor::Error::what() const noexcept -> const char*
+{
+    switch (m_type)
+    {
+    case Type::InvalidBlock:
+        return "INVALID_BLOCK";
+
+    case Type::InvalidLength:
+        return "INVALID_LENGTH";
+
+    case Type::InvalidData:
+        return "INVALID_DATA";
+
+    case Type::InvalidChecksum:
+        return "INVALID_CHECKSUM";
+
+    default:
+        return "UNKNOWN_DECOMPRESSOR_ERROR";
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
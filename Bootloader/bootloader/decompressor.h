@@ -0,0 +1,122 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "config.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <span>
+
+// Decompresses images sent as a stream of LZSS blocks, each encoded in Base64 to fit on a line:
+//
+//   Block:  address (4), length (2), CRC-32 (4), compressed data
+//   Data:   groups of a flag byte followed by up to 8 items, least significant flag first
+//   Item:   flag set:   literal byte
+//           flag clear: big-endian 16-bit match, distance - 1 in the upper 10 bits and
+//                       length - 3 in the lower 6 bits
+//
+// All numbers in the header are little-endian. The CRC covers the address and length fields
+// followed by the decompressed data, so a corrupted address can't misdirect a valid block.
+// Matches may reach back into preceding blocks of the stream, so zero-filled areas and repeated
+// tables shrink to a fraction, but they never extend beyond the end of their own block. Each
+// block is verified on its own, so a corrupted one can be retransmitted without restarting the
+// stream.
+
+class Decompressor
+{
+public:
+    static constexpr size_t WindowSize = 1024;
+    static constexpr size_t MaximumLength = 1024;
+
+    static constexpr size_t HeaderSize = 10;
+
+    // Base64 carries 3 bytes in 4 characters, and the block has to fit into a frame
+    static constexpr size_t MaximumBlockSize = Config::MaximumFrameSize / 4 * 3;
+
+    static_assert(MaximumBlockSize > HeaderSize, "Frame size too small for compressed blocks.");
+
+    struct Output
+    {
+        uint32_t address;
+        std::span<const uint8_t> data;
+    };
+
+    class Error;
+
+public:
+    void reset();
+
+    // Data remains valid until the next call, and only becomes part of the window on success
+    auto decompress(std::span<const char> block) -> Output;
+
+private:
+    auto decode(std::span<const char> block) -> std::span<const uint8_t>;
+    void expand(std::span<const uint8_t> data, uint8_t* output, size_t length) const;
+
+private:
+    // The window followed by the block being decompressed, which is then moved into the window
+    std::array<uint8_t, WindowSize + MaximumLength> m_buffer;
+    size_t m_windowLength = 0;
+    size_t m_outputLength = 0;
+
+    std::array<uint8_t, MaximumBlockSize> m_block;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+class Decompressor::Error : public std::exception
+{
+public:
+    enum class Type
+    {
+        InvalidBlock,
+        InvalidLength,
+        InvalidData,
+        InvalidChecksum
+    };
+
+public:
+    Error(Type type) : m_type(type) {}
+
+    auto type() const -> Type { return m_type; }
+    auto what() const noexcept -> const char* override;
+
+private:
+    Type m_type;
+};
+
+// ---------------------------------------------------------------------------------------------- //
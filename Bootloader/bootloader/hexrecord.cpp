@@ -93,73 +93,107 @@ auto HexRecord::computeChecksum() const -> uint8_t
 
 // ---------------------------------------------------------------------------------------------- //
 
-template <typename T>
-auto hexToNum(std::span<const char> hex) -> T
-{
-    T result = 0;
+namespace {
+    constexpr uint8_t InvalidDigit = 0xff;
 
-    for (char c : hex)
+    constexpr auto makeHexTable() -> std::array<uint8_t, 256>
     {
-        if (c >= '0' && c <= '9')
-            c = c - '0';
-        else if (c >= 'A' && c <= 'F')
-            c = c - 'A' + 10;
-        else if (c >= 'a' && c <= 'f')
-            c = c - 'a' + 10;
-        else
-            return 0;
-
-        result = (result<<4) | c;
-    }
+        std::array<uint8_t, 256> table = {};
+        table.fill(InvalidDigit);
 
-    return result;
-}
+        for (uint8_t i = 0; i < 10; ++i)
+            table['0' + i] = i;
 
-// ---------------------------------------------------------------------------------------------- //
+        for (uint8_t i = 0; i < 6; ++i)
+        {
+            table['A' + i] = 10 + i;
+            table['a' + i] = 10 + i;
+        }
 
-template <typename T>
-auto scanValue(const char*& str) -> T
-{
-    std::array<char, 2*sizeof(T)> value = {};
+        return table;
+    }
 
-    if (std::strlen(str) < value.size())
-        throw HexRecord::ParserError(HexRecord::ParserError::Type::InvalidRecord);
+    constexpr std::array<uint8_t, 256> HexTable = makeHexTable();
+
+    // Decodes two hex digits. Invalid digits set bits above the lower nibble, which the caller
+    // collects in a single flag rather than branching on every byte.
+    inline auto decodeByte(const char* hex, uint8_t* invalid) -> uint8_t
+    {
+        const uint8_t high = HexTable[static_cast<uint8_t>(hex[0])];
+        const uint8_t low = HexTable[static_cast<uint8_t>(hex[1])];
 
-    for (char& byte : value)
-        byte = *(str++);
+        *invalid |= (high | low) & 0xf0;
 
-    return hexToNum<T>(value);
+        return static_cast<uint8_t>((high << 4) | (low & 0x0f));
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto HexRecord::fromString(const char* str) -> HexRecord
 {
-    HexRecord record;
+    return fromString(std::span(str, std::strlen(str)));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HexRecord::fromString(std::span<const char> str) -> HexRecord
+{
+    // Record layout: ':' LL AAAA TT DD... CC
+    static constexpr size_t HeaderSize = 4;
 
-    if (std::strlen(str) < 1 || *(str++) != ':')
+    if (str.size() < 1 + 2 * HeaderSize || str[0] != ':')
         throw ParserError(ParserError::Type::InvalidRecord);
 
-    record.m_length = scanValue<uint8_t>(str);
+    const char* hex = str.data() + 1;
+
+    uint8_t invalid = 0;
+    uint8_t checksum = 0;
+
+    std::array<uint8_t, HeaderSize> header;
+
+    for (uint8_t& byte : header)
+    {
+        byte = decodeByte(hex, &invalid);
+        checksum += byte;
+        hex += 2;
+    }
+
+    if (invalid)
+        throw ParserError(ParserError::Type::InvalidRecord);
+
+    HexRecord record;
+    record.m_length = header[0];
 
     if (record.m_length > MaximumLength)
         throw ParserError(ParserError::Type::InvalidLength);
 
-    record.m_address = scanValue<uint16_t>(str);
+    record.m_address = static_cast<uint16_t>((header[1] << 8) | header[2]);
 
-    const uint8_t typeIndex = scanValue<uint8_t>(str);
-
-    if (typeIndex >= TypeCount)
+    if (header[3] >= TypeCount)
         throw ParserError(ParserError::Type::InvalidType);
 
-    record.m_type = static_cast<Type>(typeIndex);
+    record.m_type = static_cast<Type>(header[3]);
+
+    // Data and checksum must follow, without any trailing characters
+    if (str.size() != 1 + 2 * (HeaderSize + record.m_length + 1))
+        throw ParserError(ParserError::Type::InvalidRecord);
 
     for (uint8_t i = 0; i < record.m_length; ++i)
-        record.m_data[i] = scanValue<uint8_t>(str);
+    {
+        record.m_data[i] = decodeByte(hex, &invalid);
+        checksum += record.m_data[i];
+        hex += 2;
+    }
+
+    record.m_checksum = decodeByte(hex, &invalid);
+    checksum += record.m_checksum;
 
-    record.m_checksum = scanValue<uint8_t>(str);
+    if (invalid)
+        throw ParserError(ParserError::Type::InvalidRecord);
 
-    if (record.m_checksum != record.computeChecksum())
+    // The sum of all bytes including the checksum is zero for a valid record
+    if (checksum != 0)
         throw ParserError(ParserError::Type::InvalidChecksum);
 
     return record;
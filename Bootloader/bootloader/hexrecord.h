@@ -33,10 +33,14 @@
 
 #pragma once
 
+#include "config.h"
+
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdint>
 #include <exception>
+#include <span>
 
 class HexRecord
 {
@@ -53,7 +57,13 @@ public:
 
     static constexpr size_t TypeCount = 6;
 
-    static constexpr size_t MaximumLength = 32;
+    // Start code, length, address, type and checksum
+    static constexpr size_t StringOverhead = 11;
+
+    // Longer records wouldn't fit into a frame, even without anything else on the line
+    static constexpr size_t MaximumLength =
+            std::min<size_t>((Config::MaximumFrameSize - StringOverhead) / 2, UINT8_MAX);
+
     using Data = std::array<uint8_t, MaximumLength>;
 
     class ParserError;
@@ -68,6 +78,7 @@ public:
     auto computeChecksum() const -> uint8_t;
 
     static auto fromString(const char* str) -> HexRecord;
+    static auto fromString(std::span<const char> str) -> HexRecord;
 
 private:
     HexRecord() = default;
@@ -0,0 +1,316 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "base64.h"
+#include "crcengine.h"
+#include "patcher.h"
+
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    inline auto readLittleEndian(const uint8_t* bytes, size_t count) -> uint32_t
+    {
+        uint32_t value = 0;
+
+        for (size_t i = 0; i < count; ++i)
+            value |= static_cast<uint32_t>(bytes[i]) << (i*8);
+
+        return value;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Patcher::begin(Programmer* programmer, uint32_t sourceCrc, const Checksum::Record& target)
+{
+    // The source checksum is already cleared, but nothing has been written yet
+    const bool repeated = (m_programmer == programmer) && (m_position == 0) &&
+                          (m_sourceCrc == sourceCrc) && (m_target == target);
+    if (repeated)
+        return;
+
+    reset();
+
+    if (Config::ScratchSector == 0)
+        throw Error(Error::Type::PatchingDisabled);
+
+    if (!Checksum::verify(Slot::Active))
+        throw Error(Error::Type::SourceMismatch);
+
+    const Checksum::Record source = Checksum::read(Slot::Active);
+
+    if (source.crc != sourceCrc)
+        throw Error(Error::Type::SourceMismatch);
+
+    if (target.length == 0 || target.length > Slot::Active.size())
+        throw Error(Error::Type::InvalidPatch);
+
+    // From here on the source is consumed, so it must no longer be booted
+    programmer->clearChecksum();
+
+    m_programmer = programmer;
+    m_sourceCrc = sourceCrc;
+    m_sourceLength = source.length;
+    m_target = target;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Patcher::write(std::span<const char> string)
+{
+    if (!m_programmer)
+        throw Error(Error::Type::PatchNotStarted);
+
+    const std::optional<size_t> length = Base64::decode(string, m_block);
+
+    if (!length || *length < HeaderSize)
+        throw Error(Error::Type::InvalidBlock);
+
+    const uint32_t offset = readLittleEndian(&m_block[0], 4);
+    const uint32_t crc = readLittleEndian(&m_block[4], 4);
+
+    const std::span<const uint8_t> operations(m_block.data() + HeaderSize, *length - HeaderSize);
+
+    const uint32_t offsetCrc = Crc32::update<Config::ChecksumEngine>(0, m_block.data(), 4);
+    const uint32_t blockCrc = Crc32::update<Config::ChecksumEngine>(offsetCrc, operations.data(),
+                                                                    operations.size());
+    if (blockCrc != crc)
+        throw Error(Error::Type::InvalidChecksum);
+
+    if (offset != m_position)
+        throw Error(Error::Type::InvalidPatch);
+
+    // Nothing is written unless the whole block can be applied
+    validate(operations);
+
+    const uint8_t* input = operations.data();
+    const uint8_t* const end = input + operations.size();
+
+    while (input != end)
+    {
+        if (*input == CopyCode)
+        {
+            copy(readLittleEndian(input + 1, 4), readLittleEndian(input + 5, 2));
+            input += CopySize;
+        }
+        else
+        {
+            insert(input + 1, *input);
+            input += *input + 1;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Patcher::finish()
+{
+    if (m_committed)
+        return;
+
+    if (!m_programmer)
+        throw Error(Error::Type::PatchNotStarted);
+
+    const bool complete = (m_position == m_target.length);
+    const bool valid = complete && m_programmer->commitImage(m_target);
+
+    reset();
+
+    if (!complete)
+        throw Error(Error::Type::InvalidPatch);
+
+    if (!valid)
+        throw Error(Error::Type::TargetMismatch);
+
+    m_committed = true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Patcher::reset()
+{
+    m_programmer = nullptr;
+    m_position = 0;
+    m_nextSector = 0;
+    m_committed = false;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Patcher::validate(std::span<const uint8_t> operations) const
+{
+    const uint8_t* input = operations.data();
+    const uint8_t* const end = input + operations.size();
+
+    uint32_t position = m_position;
+
+    while (input != end)
+    {
+        uint32_t length = 0;
+
+        if (*input == CopyCode)
+        {
+            if (end - input < static_cast<ptrdiff_t>(CopySize))
+                throw Error(Error::Type::InvalidPatch);
+
+            const uint32_t source = readLittleEndian(input + 1, 4);
+            length = readLittleEndian(input + 5, 2);
+
+            if (source > m_sourceLength || length > m_sourceLength - source)
+                throw Error(Error::Type::InvalidPatch);
+
+            input += CopySize;
+        }
+        else
+        {
+            length = *input;
+
+            if (length == 0 || end - input <= static_cast<ptrdiff_t>(length))
+                throw Error(Error::Type::InvalidPatch);
+
+            input += length + 1;
+        }
+
+        if (length > m_target.length - position)
+            throw Error(Error::Type::InvalidPatch);
+
+        position += length;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Patcher::copy(uint32_t source, uint32_t length)
+{
+    while (length > 0)
+    {
+        const uint32_t target = Config::FirmwareStartAddress + m_position;
+        const uint32_t address = Config::FirmwareStartAddress + source;
+
+        const size_t targetSector = enterSector(target);
+        const size_t sourceSector = m_programmer->sectorOf(address);
+
+        if (sourceSector < targetSector)
+            throw Error(Error::Type::InvalidPatch);
+
+        const uint32_t sourceStart = m_programmer->sectorAddress(sourceSector);
+
+        // Stay within one sector on both sides
+        const uint32_t count = std::min({
+            length,
+            m_programmer->sectorAddress(targetSector + 1) - target,
+            m_programmer->sectorAddress(sourceSector + 1) - address
+        });
+
+        // The sector being rewritten has been moved to scratch
+        const uint32_t from = (sourceSector == targetSector)
+                                ? Config::ScratchAddress + (address - sourceStart) : address;
+
+        m_programmer->writeData(target, reinterpret_cast<const uint8_t*>(from), count);
+
+        m_position += count;
+        source += count;
+        length -= count;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Patcher::insert(const uint8_t* bytes, uint32_t length)
+{
+    while (length > 0)
+    {
+        const uint32_t target = Config::FirmwareStartAddress + m_position;
+        const size_t sector = enterSector(target);
+
+        const uint32_t count = std::min(length, m_programmer->sectorAddress(sector + 1) - target);
+
+        m_programmer->writeData(target, bytes, count);
+
+        m_position += count;
+        bytes += count;
+        length -= count;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// The image is written in order, so each sector is backed up once, right before its first write
+auto Patcher::enterSector(uint32_t address) -> size_t
+{
+    const size_t sector = m_programmer->sectorOf(address);
+
+    if (sector >= m_nextSector)
+    {
+        m_programmer->backupSector(sector);
+        m_nextSector = sector + 1;
+    }
+
+    return sector;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Patcher::Error::what() const noexcept -> const char*
+{
+    switch (m_type)
+    {
+    case Type::PatchingDisabled:
+        return "PATCHING_DISABLED";
+
+    case Type::SourceMismatch:
+        return "SOURCE_MISMATCH";
+
+    case Type::PatchNotStarted:
+        return "PATCH_NOT_STARTED";
+
+    case Type::InvalidBlock:
+        return "INVALID_BLOCK";
+
+    case Type::InvalidChecksum:
+        return "INVALID_CHECKSUM";
+
+    case Type::InvalidPatch:
+        return "INVALID_PATCH";
+
+    case Type::TargetMismatch:
+        return "TARGET_MISMATCH";
+
+    default:
+        return "UNKNOWN_PATCHER_ERROR";
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
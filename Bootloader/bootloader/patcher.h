@@ -0,0 +1,138 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "checksum.h"
+#include "config.h"
+#include "programmer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <span>
+
+// Applies a delta update to the firmware partition in place, using the current image as the
+// source. The patch is sent as a stream of blocks, each encoded in Base64 to fit on a line:
+//
+//   Block:  offset (4), CRC-32 (4), operations
+//   Copy:   0x80, source offset (4), length (2)
+//   Insert: length (1 - 127), literal bytes
+//
+// All numbers are little-endian and offsets are relative to the start of the partition. The CRC
+// covers the offset field followed by the operations. Each block continues the image at the
+// offset where the previous one ended, so a retransmitted block is recognized as such.
+//
+// The target is written sector by sector. Before a sector is rewritten its previous contents are
+// copied to the scratch sector, so copies may read from the sector being written and from any
+// later one, but not from sectors already overwritten. The checksum of the source is cleared on
+// start, so an interrupted patch leaves an invalid image, and the result is only accepted if it
+// matches the checksum announced for the target. Starting and finishing may be repeated by the
+// host if a response got lost.
+
+class Patcher
+{
+public:
+    static constexpr uint8_t CopyCode = 0x80;
+    static constexpr size_t CopySize = 7;
+
+    static constexpr size_t HeaderSize = 8;
+
+    // Base64 carries 3 bytes in 4 characters, and the block has to fit into a frame
+    static constexpr size_t MaximumBlockSize = Config::MaximumFrameSize / 4 * 3;
+
+    static_assert(MaximumBlockSize > HeaderSize + CopySize, "Frame size too small for patches.");
+
+    class Error;
+
+public:
+    void begin(Programmer* programmer, uint32_t sourceCrc, const Checksum::Record& target);
+    void write(std::span<const char> block);
+    void finish();
+
+    void reset();
+
+private:
+    void validate(std::span<const uint8_t> operations) const;
+
+    void copy(uint32_t source, uint32_t length);
+    void insert(const uint8_t* bytes, uint32_t length);
+
+    auto enterSector(uint32_t address) -> size_t;
+
+private:
+    Programmer* m_programmer = nullptr;
+
+    uint32_t m_sourceCrc = 0;
+    uint32_t m_sourceLength = 0;
+    Checksum::Record m_target = {};
+
+    uint32_t m_position = 0;
+
+    // Sectors before this one have been rewritten, the previous one is held in scratch
+    size_t m_nextSector = 0;
+
+    // Set once the image has been committed, until the next patch is started
+    bool m_committed = false;
+
+    std::array<uint8_t, MaximumBlockSize> m_block;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+class Patcher::Error : public std::exception
+{
+public:
+    enum class Type
+    {
+        PatchingDisabled,
+        SourceMismatch,
+        PatchNotStarted,
+        InvalidBlock,
+        InvalidChecksum,
+        InvalidPatch,
+        TargetMismatch
+    };
+
+public:
+    Error(Type type) : m_type(type) {}
+
+    auto type() const -> Type { return m_type; }
+    auto what() const noexcept -> const char* override;
+
+private:
+    Type m_type;
+};
+
+// ---------------------------------------------------------------------------------------------- //
@@ -35,6 +35,9 @@
 #include "config.h"
 #include "programmer.h"
 
+#include <algorithm>
+#include <cstring>
+
 // ---------------------------------------------------------------------------------------------- //
 
 #if defined(STM32F4)
@@ -67,11 +70,97 @@ namespace {
 #endif
 
     static constexpr uint32_t WordSize = sizeof(DataType);
+
+    // Records are merged in the row buffer, so they may start and end anywhere
+    static constexpr uint32_t RecordAlignment = 1;
+
+    static_assert(Config::FirmwareStartSector + Config::FirmwareSectorCount <=
+                  std::size(Config::FlashSectorSizes), "Firmware sectors exceed flash memory.");
+
+    static_assert(Config::StagingStartSector + Config::StagingSectorCount <=
+                  std::size(Config::FlashSectorSizes), "Staging sectors exceed flash memory.");
+
+    using SectorAddresses = std::array<uint32_t, Programmer::MaximumSectorCount + 1>;
+
+    // Start addresses of the slot's sectors, followed by the end of the slot
+    constexpr auto makeSectorAddresses(const Slot& slot) -> SectorAddresses
+    {
+        SectorAddresses addresses = {};
+        uint32_t address = Config::FlashBaseAddress;
+
+        for (uint32_t sector = 0; sector < slot.startSector; ++sector)
+            address += Config::FlashSectorSizes[sector] * 1024;
+
+        for (uint32_t i = 0; i < slot.sectorCount; ++i)
+        {
+            addresses[i] = address;
+            address += Config::FlashSectorSizes[slot.startSector + i] * 1024;
+        }
+
+        addresses[slot.sectorCount] = address;
+
+        return addresses;
+    }
+
+    // Whether the addresses of the slot match its sectors, with the checksum at the very end
+    constexpr auto checkSlot(const Slot& slot) -> bool
+    {
+        const SectorAddresses addresses = makeSectorAddresses(slot);
+
+        return addresses.front() == slot.startAddress &&
+               addresses[slot.sectorCount] == slot.checksumAddress + sizeof(Checksum::Record);
+    }
+
+    static_assert(checkSlot(Slot::Active), "Firmware addresses don't match the firmware sectors.");
+
+    static_assert(!Slot::Staging.enabled() || checkSlot(Slot::Staging),
+                  "Staging addresses don't match the staging sectors.");
+
+    // Whether the scratch sector lies outside the slots and can hold any firmware sector
+    constexpr auto checkScratch() -> bool
+    {
+        uint32_t address = Config::FlashBaseAddress;
+
+        for (uint32_t sector = 0; sector < Config::ScratchSector; ++sector)
+            address += Config::FlashSectorSizes[sector] * 1024;
+
+        const auto inside = [](uint32_t sector, uint32_t first, uint32_t count) {
+            return sector >= first && sector < first + count;
+        };
+
+        if (address != Config::ScratchAddress ||
+            inside(Config::ScratchSector, Config::FirmwareStartSector,
+                   Config::FirmwareSectorCount) ||
+            inside(Config::ScratchSector, Config::StagingStartSector, Config::StagingSectorCount))
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < Config::FirmwareSectorCount; ++i)
+        {
+            const uint32_t size = Config::FlashSectorSizes[Config::FirmwareStartSector + i];
+
+            if (size > Config::FlashSectorSizes[Config::ScratchSector])
+                return false;
+        }
+
+        return true;
+    }
+
+    static_assert(Config::ScratchSector < std::size(Config::FlashSectorSizes),
+                  "Scratch sector exceeds flash memory.");
+
+    static_assert(Config::ScratchSector == 0 || checkScratch(),
+                  "Scratch sector overlaps a slot or is smaller than a firmware sector.");
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-Programmer::Programmer()
+Programmer::Programmer(Owner* owner, const Slot& slot)
+    : m_owner(owner),
+      m_slot(slot),
+      m_sectorAddresses(makeSectorAddresses(slot)),
+      m_checksumSector(sectorOf(slot.checksumAddress))
 {
     HAL_FLASH_Unlock();
 }
@@ -87,28 +176,41 @@ Programmer::~Programmer()
 
 void Programmer::eraseSector(size_t sector)
 {
-    if (sector >= Config::FirmwareSectorCount)
+    if (sector >= m_slot.sectorCount)
         throw EraseError(EraseError::Type::InvalidSector, sector);
 
-    FLASH_EraseInitTypeDef eraseInit = {};
-    uint32_t sectorError = 0;
+    flushRow(); // Buffered data may belong to the sector, just as if it had already been written
+    erase(sector);
+}
 
-#if defined(STM32L4)
-    eraseInit.TypeErase    = FLASH_TYPEERASE_PAGES;
-    eraseInit.Banks        = FLASH_BANK_1;
-    eraseInit.Page         = Config::FirmwareStartSector + sector;
-    eraseInit.NbPages      = 1;
-#elif defined(STM32F4)
-    eraseInit.TypeErase    = FLASH_TYPEERASE_SECTORS;
-    eraseInit.Sector       = Config::FirmwareStartSector + sector;
-    eraseInit.NbSectors    = 1;
-    eraseInit.VoltageRange = BOOTLOADER_VOLTAGE_RANGE;
-#endif
+// ---------------------------------------------------------------------------------------------- //
 
-    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&eraseInit, &sectorError);
+// Erased one by one, which is what the HAL does for multiple sectors anyway, but this way the
+// owner can report progress in between
+void Programmer::eraseSectors(size_t first, size_t count)
+{
+    if (count == 0 || first >= m_slot.sectorCount)
+        throw EraseError(EraseError::Type::InvalidSector, first);
 
-    if (status != HAL_OK)
-        throw EraseError(EraseError::Type::EraseFailed, sectorError);
+    if (count > m_slot.sectorCount - first)
+        throw EraseError(EraseError::Type::InvalidSector, m_slot.sectorCount);
+
+    flushRow();
+
+    for (size_t sector = first; sector < first + count; ++sector)
+    {
+        if (m_owner)
+            m_owner->onSectorErase(sector);
+
+        erase(sector);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Programmer::wordSize() -> uint32_t
+{
+    return RecordAlignment;
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -146,17 +248,372 @@ void Programmer::processExtendedLinearAddress(const HexRecord& record)
 
 void Programmer::processData(const HexRecord& record)
 {
-    const HexRecord::Data& bytes = record.data();
+    writeData(m_baseAddress | record.address(), record.data().data(), record.length());
+}
 
-    const uint32_t address = m_baseAddress | record.address();
-    const uint32_t length = record.length();
+// ---------------------------------------------------------------------------------------------- //
 
-    const bool addressValid = (address % WordSize) == 0 &&
-                              (address >= Config::FirmwareStartAddress) &&
+// Takes firmware addresses, which are mapped to the slot being programmed
+void Programmer::writeData(uint32_t address, const uint8_t* bytes, uint32_t length)
+{
+    const bool addressValid = (address >= Config::FirmwareStartAddress) &&
                               (address + length <= Config::FirmwareEndAddress);
     if (!addressValid)
         throw ProgramError(ProgramError::Type::InvalidAddress, address);
 
+    bufferData(m_slot.map(address), bytes, length);
+
+    m_imageEndAddress = std::max(m_imageEndAddress, address + length);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Programmer::processEndOfFile(const HexRecord&)
+{
+    flushRow();
+
+    // Only the programmed part of the partition is checked at boot, so that boot time scales
+    // with the image rather than with the partition
+    Checksum::Record checksum = {};
+
+    if (m_imageEndAddress > Config::FirmwareStartAddress)
+        checksum.length = m_imageEndAddress - Config::FirmwareStartAddress;
+
+    checksum.crc = Checksum::compute(m_slot, checksum.length);
+
+    writeChecksum(checksum);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Copies a verified image from another slot. The checksum comes last, so an interrupted copy
+// leaves this slot invalid and the source untouched, and can simply be started over.
+void Programmer::copyImage(const Slot& source)
+{
+    const Checksum::Record checksum = Checksum::read(source);
+
+    for (uint32_t offset = 0; offset < checksum.length; offset += RowSize)
+    {
+        const auto bytes = reinterpret_cast<const uint8_t*>(source.startAddress + offset);
+        const uint32_t length = std::min(RowSize, checksum.length - offset);
+
+        bufferData(m_slot.startAddress + offset, bytes, length);
+    }
+
+    flushRow();
+    writeChecksum(checksum);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Erasing the sector holding the checksum is enough for the image to be rejected
+void Programmer::invalidateImage()
+{
+    flushRow();
+
+    if (m_owner)
+        m_owner->onSectorErase(m_checksumSector);
+
+    erase(m_checksumSector);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Copies a sector to the scratch sector before erasing it, so that it can be rewritten in place
+// while its previous contents remain readable from there
+void Programmer::backupSector(size_t sector)
+{
+    if (sector >= m_slot.sectorCount)
+        throw EraseError(EraseError::Type::InvalidSector, sector);
+
+    flushRow();
+
+    if (m_owner)
+        m_owner->onSectorErase(sector);
+
+    eraseFlash(Config::ScratchSector);
+
+    const auto bytes = reinterpret_cast<const uint8_t*>(m_sectorAddresses[sector]);
+    const uint32_t size = m_sectorAddresses[sector + 1] - m_sectorAddresses[sector];
+
+    static constexpr std::array<uint8_t, WordSize> Erased = [] {
+        std::array<uint8_t, WordSize> word = {};
+        word.fill(0xff);
+        return word;
+    }();
+
+    for (uint32_t offset = 0; offset < size; offset += WordSize)
+    {
+        // Erased words are already in place
+        if (std::memcmp(bytes + offset, Erased.data(), WordSize) != 0)
+            program(Config::ScratchAddress + offset, bytes + offset, WordSize);
+    }
+
+    erase(sector);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Flash bits can be cleared without erasing, so the checksum can be invalidated in place while
+// the rest of its sector is kept
+void Programmer::clearChecksum()
+{
+    flushRow();
+
+    static constexpr Checksum::Record Cleared = {};
+    program(m_slot.checksumAddress, reinterpret_cast<const uint8_t*>(&Cleared), sizeof(Cleared));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Finishes an image written by other means than hex records, which is only accepted if it
+// matches the expected checksum
+auto Programmer::commitImage(const Checksum::Record& checksum) -> bool
+{
+    flushRow();
+
+    if (Checksum::compute(m_slot, checksum.length) != checksum.crc)
+        return false;
+
+    writeChecksum(checksum);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Programmer::writeChecksum(const Checksum::Record& checksum)
+{
+    eraseOnWrite(m_checksumSector); // In case no data was written at all
+    program(m_slot.checksumAddress, reinterpret_cast<const uint8_t*>(&checksum), sizeof(checksum));
+
+    // A new image may follow, which has to be erased again
+    m_erasedSectors.reset();
+    m_imageEndAddress = 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Relative to the slot, as used by eraseSector()
+auto Programmer::sectorOf(uint32_t address) const -> size_t
+{
+    const auto end = m_sectorAddresses.begin() + m_slot.sectorCount + 1;
+    const auto next = std::upper_bound(m_sectorAddresses.begin() + 1, end, address);
+
+    return next - m_sectorAddresses.begin() - 1;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// The sector count yields the end of the slot
+auto Programmer::sectorAddress(size_t sector) const -> uint32_t
+{
+    return m_sectorAddresses[std::min<size_t>(sector, m_slot.sectorCount)];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Programmer::erase(size_t sector)
+{
+    eraseFlash(m_slot.startSector + sector);
+    m_erasedSectors.set(sector);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Takes a flash sector number rather than one relative to the slot
+void Programmer::eraseFlash(uint32_t sector)
+{
+    FLASH_EraseInitTypeDef eraseInit = {};
+    uint32_t sectorError = 0;
+
+#if defined(STM32L4)
+    eraseInit.TypeErase    = FLASH_TYPEERASE_PAGES;
+  #if defined(FLASH_BANK_2)
+    // Pages are numbered per bank, and the staging slot usually occupies the second one
+    eraseInit.Banks        = (sector < FLASH_PAGE_NB) ? FLASH_BANK_1 : FLASH_BANK_2;
+    eraseInit.Page         = sector % FLASH_PAGE_NB;
+  #else
+    eraseInit.Banks        = FLASH_BANK_1;
+    eraseInit.Page         = sector;
+  #endif
+    eraseInit.NbPages      = 1;
+#elif defined(STM32F4)
+    eraseInit.TypeErase    = FLASH_TYPEERASE_SECTORS;
+    eraseInit.Sector       = sector;
+    eraseInit.NbSectors    = 1;
+    eraseInit.VoltageRange = BOOTLOADER_VOLTAGE_RANGE;
+#endif
+
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&eraseInit, &sectorError);
+
+    if (status != HAL_OK)
+        throw EraseError(EraseError::Type::EraseFailed, sectorError);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Programmer::eraseOnWrite(size_t sector)
+{
+    if (m_erasedSectors.test(sector))
+        return;
+
+    // Erasing the checksum first invalidates the old image before any of it is overwritten
+    if (m_erasedSectors.none() && sector != m_checksumSector)
+        eraseOnWrite(m_checksumSector);
+
+    if (m_owner)
+        m_owner->onSectorErase(sector);
+
+    erase(sector);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Programmer::bufferData(uint32_t address, const uint8_t* bytes, uint32_t length)
+{
+    while (length > 0)
+    {
+        const uint32_t rowAddress = address & ~(RowSize - 1);
+
+        if (!m_rowPending || rowAddress != m_rowAddress)
+        {
+            flushRow();
+            eraseOnWrite(sectorOf(rowAddress)); // Rows never cross sector boundaries
+            loadRow(rowAddress);
+        }
+
+        const uint32_t offset = address - rowAddress;
+        const uint32_t count = std::min(length, RowSize - offset);
+
+        checkProgrammable(offset, bytes, count);
+        std::memcpy(m_row.data() + offset, bytes, count);
+
+        // A row filled up to its end is written right away, so that its data is in flash before
+        // the record completing it is acknowledged
+        if (offset + count == RowSize)
+            flushRow();
+
+        address += count;
+        bytes += count;
+        length -= count;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Words can only be programmed once after erasing. Flash with ECC, such as on the STM32L4,
+// doesn't even allow clearing further bits, so changing data written earlier is refused before
+// the record is acknowledged, rather than failing once the row is flushed.
+void Programmer::checkProgrammable(uint32_t offset, const uint8_t* bytes, uint32_t length) const
+{
+    const auto flash = reinterpret_cast<const uint8_t*>(m_rowAddress);
+
+    const uint32_t first = offset & ~(WordSize - 1);
+    const uint32_t last = (offset + length + WordSize - 1) & ~(WordSize - 1);
+
+    for (uint32_t wordOffset = first; wordOffset < last; wordOffset += WordSize)
+    {
+        bool erased = true;
+        bool changed = false;
+
+        for (uint32_t i = wordOffset; i < wordOffset + WordSize; ++i)
+        {
+            const bool written = (i >= offset && i < offset + length);
+            const uint8_t byte = written ? bytes[i - offset] : m_row[i];
+
+            erased = erased && (flash[i] == 0xff);
+            changed = changed || (byte != flash[i]);
+        }
+
+        if (!erased && changed)
+            throw ProgramError(ProgramError::Type::AlreadyProgrammed, m_rowAddress + wordOffset);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Starting from the current flash contents pads partial words with the erased value, and also
+// keeps data written earlier if a row is revisited
+void Programmer::loadRow(uint32_t address)
+{
+    std::memcpy(m_row.data(), reinterpret_cast<const uint8_t*>(address), RowSize);
+
+    m_rowAddress = address;
+    m_rowPending = true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Programmer::flushRow()
+{
+    if (!m_rowPending)
+        return;
+
+    m_rowPending = false;
+
+#if defined(STM32L4)
+    if (canProgramRow())
+    {
+        programRow();
+        return;
+    }
+#endif
+
+    const auto flash = reinterpret_cast<const uint8_t*>(m_rowAddress);
+
+    for (uint32_t offset = 0; offset < RowSize; offset += WordSize)
+    {
+        if (std::memcmp(m_row.data() + offset, flash + offset, WordSize) != 0)
+            program(m_rowAddress + offset, m_row.data() + offset, WordSize);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+#if defined(STM32L4)
+// Fast programming writes every double word of the row, so it's only used if all of them are
+// erased and would be written anyway. Words left blank could not be programmed later on.
+auto Programmer::canProgramRow() const -> bool
+{
+    static constexpr DataType Erased = ~DataType(0);
+
+    const auto flash = reinterpret_cast<const uint8_t*>(m_rowAddress);
+
+    for (uint32_t offset = 0; offset < RowSize; offset += WordSize)
+    {
+        DataType data;
+        DataType current;
+
+        std::memcpy(&data, m_row.data() + offset, WordSize);
+        std::memcpy(&current, flash + offset, WordSize);
+
+        if (data == Erased || current != Erased)
+            return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Programmer::programRow()
+{
+    const auto source = reinterpret_cast<uint32_t>(m_row.data());
+
+    auto status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_FAST, m_rowAddress, source);
+
+    if (status != HAL_OK)
+        throw ProgramError(ProgramError::Type::WriteFailed, HAL_FLASH_GetError());
+
+    if (std::memcmp(m_row.data(), reinterpret_cast<const uint8_t*>(m_rowAddress), RowSize) != 0)
+        throw ProgramError(ProgramError::Type::DataMismatch);
+}
+#endif
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Programmer::program(uint32_t address, const uint8_t* bytes, uint32_t length)
+{
     for (uint32_t offset = 0; offset < length; offset += WordSize)
     {
         DataType data = 0;
@@ -181,18 +638,6 @@ void Programmer::processData(const HexRecord& record)
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Programmer::processEndOfFile(const HexRecord&)
-{
-    const uint32_t checksum = Checksum::compute();
-
-    auto status = HAL_FLASH_Program(ProgramType, Config::ChecksumAddress, checksum);
-
-    if (status != HAL_OK)
-        throw ProgramError(ProgramError::Type::WriteFailed, HAL_FLASH_GetError());
-}
-
-// ---------------------------------------------------------------------------------------------- //
-
 Programmer::EraseError::EraseError(Type type, uint32_t sector)
     : m_type(type), m_sector(sector) {}
 
@@ -233,6 +678,9 @@ auto Programmer::ProgramError::what() const noexcept -> const char*
     case Type::DataMismatch:
         return "DATA_MISMATCH";
 
+    case Type::AlreadyProgrammed:
+        return "ALREADY_PROGRAMMED";
+
     default:
         return "UNKNOWN_PROGRAM_ERROR";
     }
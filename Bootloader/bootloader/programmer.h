@@ -33,8 +33,14 @@
 
 #pragma once
 
+#include "checksum.h"
+#include "config.h"
 #include "hexrecord.h"
+#include "slot.h"
 
+#include <algorithm>
+#include <array>
+#include <bitset>
 #include <exception>
 
 // ---------------------------------------------------------------------------------------------- //
@@ -45,20 +51,83 @@ public:
     class EraseError;
     class ProgramError;
 
+    class Owner
+    {
+        friend class Programmer;
+        virtual void onSectorErase(size_t sector) = 0;
+    };
+
+    // Matches the row size of STM32L4 fast programming
+    static constexpr uint32_t RowSize = 256;
+
+    static constexpr size_t MaximumSectorCount = std::max(Config::FirmwareSectorCount,
+                                                          Config::StagingSectorCount);
+
 public:
-    Programmer();
+    Programmer(Owner* owner = nullptr, const Slot& slot = Slot::Active);
     ~Programmer();
 
     void eraseSector(size_t sector);
+    void eraseSectors(size_t first, size_t count);
     void processRecord(const HexRecord& record);
+    void writeData(uint32_t address, const uint8_t* bytes, uint32_t length);
+
+    void copyImage(const Slot& source);
+    void invalidateImage();
+
+    void backupSector(size_t sector);
+    void clearChecksum();
+    auto commitImage(const Checksum::Record& checksum) -> bool;
+
+    auto sectorOf(uint32_t address) const -> size_t;
+    auto sectorAddress(size_t sector) const -> uint32_t;
+
+    static auto wordSize() -> uint32_t;
 
 private:
     void processExtendedLinearAddress(const HexRecord& record);
     void processData(const HexRecord& record);
     void processEndOfFile(const HexRecord& record);
 
+    void writeChecksum(const Checksum::Record& checksum);
+
+    void erase(size_t sector);
+    void eraseFlash(uint32_t sector);
+    void eraseOnWrite(size_t sector);
+
+    void bufferData(uint32_t address, const uint8_t* bytes, uint32_t length);
+    void checkProgrammable(uint32_t offset, const uint8_t* bytes, uint32_t length) const;
+    void loadRow(uint32_t address);
+    void flushRow();
+
+#if defined(STM32L4)
+    auto canProgramRow() const -> bool;
+    void programRow();
+#endif
+
+    void program(uint32_t address, const uint8_t* bytes, uint32_t length);
+
 private:
+    Owner* m_owner;
+
+    const Slot& m_slot;
+
+    // Start addresses of the slot's sectors, followed by the end of the slot
+    std::array<uint32_t, MaximumSectorCount + 1> m_sectorAddresses;
+    size_t m_checksumSector;
+
     uint32_t m_baseAddress = 0;
+    uint32_t m_imageEndAddress = 0;
+
+    // Sectors erased since unlocking or the last end of file, the others are erased on first write
+    std::bitset<MaximumSectorCount> m_erasedSectors;
+
+    // Data records are collected here and written a row at a time, so they're only guaranteed
+    // to be in flash once the row is complete or left, a sector is erased or the end of file is
+    // reached. Errors programming a row are reported for the record causing the flush.
+    alignas(uint64_t) std::array<uint8_t, RowSize> m_row;
+    uint32_t m_rowAddress = 0;
+    bool m_rowPending = false;
 };
 
 // ---------------------------------------------------------------------------------------------- //
@@ -94,7 +163,8 @@ public:
     {
         InvalidAddress,
         WriteFailed,
-        DataMismatch
+        DataMismatch,
+        AlreadyProgrammed
     };
 
 public:
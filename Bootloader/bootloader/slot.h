@@ -0,0 +1,85 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "config.h"
+
+#include <cstdint>
+
+// A range of flash sectors holding one firmware image, followed by its checksum record at the
+// end of the last sector. Images are always linked for the active slot, which is the one booted.
+// The staging slot receives them at an offset while the firmware keeps running.
+struct Slot
+{
+    uint32_t startSector; // Absolute, as passed to the HAL
+    uint32_t sectorCount;
+    uint32_t startAddress;
+    uint32_t checksumAddress;
+
+    constexpr auto enabled() const -> bool { return sectorCount > 0; }
+    constexpr auto size() const -> uint32_t { return checksumAddress - startAddress; }
+
+    // Maps an address of the linked image to this slot
+    constexpr auto map(uint32_t address) const -> uint32_t
+    {
+        return address - Config::FirmwareStartAddress + startAddress;
+    }
+
+    static const Slot Active;
+    static const Slot Staging;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+inline constexpr Slot Slot::Active = {
+    Config::FirmwareStartSector,
+    Config::FirmwareSectorCount,
+    Config::FirmwareStartAddress,
+    Config::ChecksumAddress
+};
+
+inline constexpr Slot Slot::Staging = {
+    Config::StagingStartSector,
+    Config::StagingSectorCount,
+    Config::StagingStartAddress,
+    Config::StagingEndAddress
+};
+
+static_assert(!Slot::Staging.enabled() || Slot::Staging.size() >= Slot::Active.size(),
+              "Staging slot is smaller than the firmware partition.");
+
+static_assert(!Slot::Staging.enabled() ||
+              Slot::Staging.startSector >= Slot::Active.startSector + Slot::Active.sectorCount ||
+              Slot::Staging.startSector + Slot::Staging.sectorCount <= Slot::Active.startSector,
+              "Staging slot overlaps the firmware partition.");
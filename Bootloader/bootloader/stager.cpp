@@ -0,0 +1,157 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "checksum.h"
+#include "slot.h"
+#include "stager.h"
+
+#include <new>
+
+// ---------------------------------------------------------------------------------------------- //
+
+Stager::Stager(Owner* owner)
+    : m_owner(owner) {}
+
+// ---------------------------------------------------------------------------------------------- //
+
+Stager::~Stager()
+{
+    lock();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Stager::info() const -> const Info&
+{
+    return m_info;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Stager::getImageValid() const -> bool
+{
+    if (!m_imageValid)
+        m_imageValid = Checksum::verify(Slot::Staging);
+
+    return *m_imageValid;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Starts over with a fresh programmer, like the bootloader does
+void Stager::unlock()
+{
+    if (!Slot::Staging.enabled())
+        throw Error(Error::Type::StagingDisabled);
+
+    lock();
+    m_programmer = new (m_programmerBuffer.data()) Programmer(this, Slot::Staging);
+
+    m_imageValid.reset();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Stager::lock()
+{
+    if (m_programmer)
+    {
+        m_programmer->~Programmer();
+        m_programmer = nullptr;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Stager::eraseSector(size_t sector)
+{
+    if (!m_programmer)
+        throw Error(Error::Type::FirmwareLocked);
+
+    m_imageValid.reset();
+    m_programmer->eraseSector(sector);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Stager::eraseSectors(size_t first, size_t count)
+{
+    if (!m_programmer)
+        throw Error(Error::Type::FirmwareLocked);
+
+    m_imageValid.reset();
+    m_programmer->eraseSectors(first, count);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Stager::writeHexRecord(std::span<const char> string)
+{
+    if (!m_programmer)
+        throw Error(Error::Type::FirmwareLocked);
+
+    const auto record = HexRecord::fromString(string);
+
+    m_imageValid.reset();
+    m_programmer->processRecord(record);
+
+    if (record.type() == HexRecord::Type::EndOfFile)
+        m_imageValid = Checksum::verify(Slot::Staging);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Stager::onSectorErase(size_t sector)
+{
+    if (m_owner)
+        m_owner->onSectorErase(sector);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Stager::Error::what() const noexcept -> const char*
+{
+    switch (m_type)
+    {
+    case Type::StagingDisabled:
+        return "STAGING_DISABLED";
+
+    case Type::FirmwareLocked:
+        return "FIRMWARE_LOCKED";
+
+    default:
+        return "UNKNOWN_STAGER_ERROR";
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,117 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "config.h"
+#include "programmer.h"
+
+#include <array>
+#include <exception>
+#include <optional>
+#include <span>
+
+// Writes new images to the staging slot from the running firmware. The bootloader installs a
+// valid staged image on the next reset, so updating only takes a single reboot.
+class Stager : private Programmer::Owner
+{
+public:
+    struct Info
+    {
+        size_t sectorCount = Config::StagingSectorCount;
+        uint32_t firmwareStartAddress = Config::FirmwareStartAddress;
+        uint32_t firmwareEndAddress = Config::FirmwareEndAddress;
+        uint32_t wordSize = Programmer::wordSize();
+        bool eraseOnWrite = true;
+    };
+
+    class Error;
+
+    class Owner
+    {
+        friend class Stager;
+        virtual void onSectorErase(size_t sector) = 0;
+    };
+
+public:
+    Stager(Owner* owner = nullptr);
+    virtual ~Stager();
+
+    auto info() const -> const Info&;
+
+    auto getImageValid() const -> bool;
+
+    void unlock();
+    void lock();
+
+    void eraseSector(size_t sector);
+    void eraseSectors(size_t first, size_t count);
+    void writeHexRecord(std::span<const char> record);
+
+private:
+    void onSectorErase(size_t sector) override;
+
+private:
+    Owner* m_owner;
+
+    alignas(Programmer) std::array<char, sizeof(Programmer)> m_programmerBuffer;
+    Programmer* m_programmer = nullptr;
+
+    // Verified on first query, cleared whenever the staging slot may change
+    mutable std::optional<bool> m_imageValid;
+
+    Info m_info;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+class Stager::Error : public std::exception
+{
+public:
+    enum class Type
+    {
+        StagingDisabled,
+        FirmwareLocked
+    };
+
+public:
+    Error(Type type) : m_type(type) {}
+
+    auto type() const -> Type { return m_type; }
+    auto what() const noexcept -> const char* override;
+
+private:
+    Type m_type;
+};
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,228 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+
+#pragma once
+
+#include "string.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+// Maps request tags to handlers in a hash table built at compile time, so that dispatching a
+// request costs one hash over its tag and a single comparison, regardless of the table size.
+template <typename T, size_t N>
+class CommandTable
+{
+public:
+    static constexpr size_t MaximumArguments = 3;
+
+    using Arguments = std::span<const StaticStringView>; // Valid during the handler call only
+
+    using Handler = void (T::*)();
+    using ArgumentHandler = void (T::*)(Arguments arguments);
+
+    struct Command
+    {
+        consteval Command(const char* tag, Handler handler);
+        consteval Command(const char* tag, size_t minimumArguments, size_t maximumArguments,
+                          ArgumentHandler handler);
+
+        const char* tag;
+        size_t tagSize;
+        uint32_t hash;
+
+        size_t minimumArguments = 0;
+        size_t maximumArguments = 0; // Any further arguments are ignored
+
+        Handler handler = nullptr;
+        ArgumentHandler argumentHandler = nullptr;
+    };
+
+    enum class Result
+    {
+        Handled,
+        UnknownCommand,
+        MissingParameter
+    };
+
+public:
+    consteval CommandTable(const Command (&commands)[N], char separator = ' ');
+
+    auto dispatch(T* object, const String& data) const -> Result;
+
+    static constexpr auto hash(const char* data, size_t size) -> uint32_t;
+
+private:
+    auto find(const char* tag, size_t size) const -> const Command*;
+
+    // Deliberately not constexpr, so calling it while building the table fails compilation.
+    // This catches duplicate tags and invalid argument counts.
+    static void invalidCommand();
+
+private:
+    // At most half of the slots are used, which keeps probe sequences short
+    static constexpr size_t SlotCount = std::bit_ceil(2 * N);
+    static_assert(N < 255, "Too many commands.");
+
+    std::array<Command, N> m_commands;
+    std::array<uint8_t, SlotCount> m_slots = {}; // Index of command plus one, zero if empty
+
+    char m_separator;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+template <typename T, size_t N>
+consteval CommandTable<T, N>::Command::Command(const char* tag, Handler handler)
+    : tag(tag),
+      tagSize(std::string_view(tag).size()),
+      hash(CommandTable::hash(tag, tagSize)),
+      handler(handler) {}
+
+// ---------------------------------------------------------------------------------------------- //
+
+template <typename T, size_t N>
+consteval CommandTable<T, N>::Command::Command(const char* tag, size_t minimumArguments,
+                                               size_t maximumArguments, ArgumentHandler handler)
+    : tag(tag),
+      tagSize(std::string_view(tag).size()),
+      hash(CommandTable::hash(tag, tagSize)),
+      minimumArguments(minimumArguments),
+      maximumArguments(maximumArguments),
+      argumentHandler(handler)
+{
+    if (minimumArguments > maximumArguments || maximumArguments > MaximumArguments)
+        invalidCommand();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+template <typename T, size_t N>
+consteval CommandTable<T, N>::CommandTable(const Command (&commands)[N], char separator)
+    : m_commands(std::to_array(commands)),
+      m_separator(separator)
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        const Command& command = m_commands[i];
+        size_t slot = command.hash % SlotCount;
+
+        while (m_slots[slot] != 0)
+        {
+            const Command& other = m_commands[m_slots[slot] - 1];
+
+            if (std::string_view(other.tag) == std::string_view(command.tag))
+                invalidCommand();
+
+            slot = (slot + 1) % SlotCount;
+        }
+
+        m_slots[slot] = static_cast<uint8_t>(i + 1);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+template <typename T, size_t N>
+auto CommandTable<T, N>::dispatch(T* object, const String& data) const -> Result
+{
+    const auto tokens = data.tokens(m_separator);
+    auto token = tokens.begin();
+
+    const Command* command = find(token->data(), token->size());
+
+    if (!command)
+        return Result::UnknownCommand;
+
+    if (command->handler)
+    {
+        (object->*command->handler)();
+        return Result::Handled;
+    }
+
+    std::array<StaticStringView, MaximumArguments> arguments;
+    size_t count = 0;
+
+    while (++token != tokens.end() && count < command->maximumArguments)
+        arguments[count++] = *token;
+
+    if (count < command->minimumArguments)
+        return Result::MissingParameter;
+
+    (object->*command->argumentHandler)({ arguments.data(), count });
+    return Result::Handled;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// 32-bit FNV-1a, cheap to compute and well distributed for short strings
+template <typename T, size_t N>
+constexpr auto CommandTable<T, N>::hash(const char* data, size_t size) -> uint32_t
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+template <typename T, size_t N>
+auto CommandTable<T, N>::find(const char* tag, size_t size) const -> const Command*
+{
+    size_t slot = hash(tag, size) % SlotCount;
+
+    while (m_slots[slot] != 0)
+    {
+        const Command& command = m_commands[m_slots[slot] - 1];
+
+        if (command.tagSize == size && std::memcmp(command.tag, tag, size) == 0)
+            return &command;
+
+        slot = (slot + 1) % SlotCount;
+    }
+
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------------------------- //
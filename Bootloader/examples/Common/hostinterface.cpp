@@ -33,39 +33,96 @@
 
 #include "hostinterface.h"
 
+#include <algorithm>
+#include <cstring>
+
+// ---------------------------------------------------------------------------------------------- //
+
+HostInterface* HostInterface::s_instance = nullptr;
+HostInterface* HostInterface::s_receiver = nullptr;
+
 // ---------------------------------------------------------------------------------------------- //
 
 HostInterface::HostInterface(Owner* owner)
     : m_owner(owner)
 {
+    HAL_UART_RegisterCallback(m_handle, HAL_UART_TX_COMPLETE_CB_ID,
+                              &HostInterface::transmitCompleteCallback);
+    HAL_UART_RegisterCallback(m_handle, HAL_UART_RX_HALFCOMPLETE_CB_ID,
+                              &HostInterface::receiveEventCallback);
+    HAL_UART_RegisterCallback(m_handle, HAL_UART_RX_COMPLETE_CB_ID,
+                              &HostInterface::receiveEventCallback);
+    HAL_UART_RegisterCallback(m_handle, HAL_UART_ERROR_CB_ID, &HostInterface::errorCallback);
+
+    s_receiver = this;
+
+    // The DMA stream is configured for circular mode, so reception only has to be restarted
+    // after receive errors
     HAL_UART_Receive_DMA(m_handle, m_rxBuffer.data(), m_rxBuffer.size());
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
+HostInterface::~HostInterface()
+{
+    if (s_instance == this)
+        s_instance = nullptr;
+
+    if (s_receiver == this)
+        s_receiver = nullptr;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void HostInterface::update()
 {
-    static constexpr const char* LineTerminator = "\r\n";
-    static constexpr size_t LineTerminatorLength = 2;
+    // Picks up queued data in case a transfer could not be started before
+    if (m_txCount == 0 && m_txHead != m_txTail)
+        startTransmit();
 
-    const size_t size = m_rxBuffer.size() - m_handle->hdmarx->Instance->NDTR;
+    const auto data = reinterpret_cast<const char*>(m_rxBuffer.data());
+    size_t writePosition = receivePosition();
 
-    for (size_t i = m_currentData.size(); i < size; ++i)
+    // Requests following a reset command are left to whatever runs after the reset
+    while (!m_sentFunction)
     {
-        m_currentData += m_rxBuffer[i];
-
-        if (m_currentData.endsWith(LineTerminator))
+        // Whatever was received around the error is lost, and reception starts over at the
+        // beginning of the buffer
+        if (m_rxRestarted)
         {
-            m_currentData.trim(LineTerminatorLength);
+            m_rxRestarted = false;
+            m_readPosition = 0;
+            writePosition = receivePosition();
 
-            m_owner->onHostDataReceived(m_currentData);
-            restartReceive();
+            discardData();
+            continue;
         }
-        else if (m_handle->hdmarx->Instance->NDTR == 0)
+
+        if (m_readPosition == writePosition)
+            return;
+
+        // Handling a request may block long enough for the DMA to lap the buffer, e.g. while
+        // erasing, so check before each one rather than parsing overwritten data
+        const size_t latestPosition = receivePosition();
+
+        if (m_rxRestarted)
+            continue;
+
+        if (latestPosition - m_readPosition > m_rxBuffer.size())
         {
-            m_owner->onHostDataOverflow();
-            restartReceive();
+            // Continues with the oldest data left, skipping up to the next complete request
+            m_readPosition = latestPosition - m_rxBuffer.size();
+            writePosition = latestPosition;
+
+            discardData();
+            continue;
         }
+
+        const size_t offset = m_readPosition % m_rxBuffer.size();
+        const size_t count = std::min(writePosition - m_readPosition,
+                                      m_rxBuffer.size() - offset);
+
+        m_readPosition += processData(data + offset, count);
     }
 }
 
@@ -73,22 +130,229 @@ void HostInterface::update()
 
 void HostInterface::sendData(const String& data)
 {
-    static const std::array<uint8_t, 2> terminator = { '\r', '\n' };
+    const size_t size = data.size() + LineTerminatorSize;
+
+    // Only blocks if the host doesn't keep up with the responses
+    while (TransmitBufferSize - (m_txHead - m_txTail) < size)
+    {
+        startTransmit();
+        __WFI();
+    }
+
+    queueData(data.data(), data.size());
+    queueData(LineTerminator, LineTerminatorSize);
+
+    startTransmit();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// The function is called as soon as the last byte queued so far has left the UART, rather than
+// after a fixed delay that has to allow for the slowest host
+void HostInterface::callWhenSent(SentFunction function)
+{
+    __disable_irq();
+
+    const bool sent = (m_txHead == m_txTail);
+
+    if (!sent)
+        m_sentFunction = function;
+
+    __enable_irq();
+
+    if (sent)
+        function();
+    else
+        startTransmit();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Returns the number of bytes processed, which stops after each request
+auto HostInterface::processData(const char* data, size_t size) -> size_t
+{
+    const char* begin = data;
+
+    while (size > 0)
+    {
+        const auto end = static_cast<const char*>(std::memchr(data, '\n', size));
+        const size_t count = end ? end - data : size;
+
+        appendData(data, count);
+
+        if (!end)
+            return data + count - begin;
+
+        data += count + 1;
+        size -= count + 1;
+
+        if (m_discardingData)
+        {
+            m_discardingData = false;
+            continue;
+        }
+
+        // A line feed on its own doesn't terminate the line
+        if (!m_currentData.endsWith('\r'))
+        {
+            appendData(end, 1);
+            continue;
+        }
+
+        m_currentData.trim(LineTerminatorSize - 1);
+        m_owner->onHostDataReceived(m_currentData);
+        m_currentData.clear();
+
+        break;
+    }
+
+    return data - begin;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostInterface::appendData(const char* data, size_t size)
+{
+    if (m_discardingData)
+        return;
 
-    std::copy(data.cbegin(), data.cend(), m_txBuffer.begin());
-    std::copy(terminator.cbegin(), terminator.cend(), m_txBuffer.begin() + data.size());
+    // Skip the rest of an oversized line, the next one may fit again
+    if (m_currentData.size() + size > String::Capacity)
+    {
+        discardData();
+        return;
+    }
 
-    HAL_UART_Transmit_DMA(m_handle, m_txBuffer.data(), data.size() + terminator.size());
+    m_currentData.append(data, size);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void HostInterface::restartReceive()
+// Drops the line received so far along with its remainder, and reports the overflow. If data was
+// lost right at the end of a line, the following one is dropped as well.
+void HostInterface::discardData()
 {
     m_currentData.clear();
+    m_discardingData = true;
 
-    HAL_UART_AbortReceive(m_handle);
-    HAL_UART_Receive_DMA(m_handle, m_rxBuffer.data(), m_rxBuffer.size());
+    m_owner->onHostDataOverflow();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostInterface::queueData(const char* data, size_t size)
+{
+    const size_t offset = m_txHead % TransmitBufferSize;
+    const size_t count = std::min(size, TransmitBufferSize - offset);
+
+    std::copy_n(data, count, m_txBuffer.begin() + offset);
+    std::copy_n(data + count, size - count, m_txBuffer.begin());
+
+    m_txHead += size;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostInterface::startTransmit()
+{
+    __disable_irq();
+
+    // The completion callback goes to whichever interface started the transfer
+    if (m_txCount == 0 && (!s_instance || s_instance->m_txCount == 0))
+    {
+        s_instance = this;
+        transmitNext();
+    }
+
+    __enable_irq();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostInterface::transmitNext()
+{
+    const size_t size = m_txHead - m_txTail;
+
+    if (size == 0)
+        return;
+
+    // A transfer ends at the end of the buffer, the next one continues at its start
+    const size_t offset = m_txTail % TransmitBufferSize;
+    const size_t count = std::min(size, TransmitBufferSize - offset);
+
+    if (HAL_UART_Transmit_DMA(m_handle, m_txBuffer.data() + offset, count) == HAL_OK)
+        m_txCount = count;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Total number of bytes received since reception was started
+auto HostInterface::receivePosition() const -> size_t
+{
+    static constexpr size_t HalfSize = ReceiveBufferSize / 2;
+
+    size_t halfCount = 0;
+    size_t remaining = 0;
+
+    // Retries if a half or full transfer interrupt came in between
+    do {
+        halfCount = m_rxHalfCount;
+        remaining = m_handle->hdmarx->Instance->NDTR;
+    } while (halfCount != m_rxHalfCount);
+
+    // The counter reloads on wrap-around, but may briefly read zero on some devices
+    const size_t writeIndex = (ReceiveBufferSize - remaining) % ReceiveBufferSize;
+
+    // The interrupt may lag behind the counter, so the position is only taken as at least the
+    // last half passed. The buffer size is a power of two, so the offset wraps correctly.
+    const size_t base = halfCount * HalfSize;
+    return base + (writeIndex - base) % ReceiveBufferSize;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostInterface::transmitCompleteCallback(UART_HandleTypeDef*)
+{
+    if (!s_instance)
+        return;
+
+    s_instance->m_txTail = s_instance->m_txTail + s_instance->m_txCount;
+    s_instance->m_txCount = 0;
+
+    s_instance->transmitNext();
+
+    const SentFunction function = s_instance->m_sentFunction;
+
+    if (function && s_instance->m_txHead == s_instance->m_txTail)
+    {
+        s_instance->m_sentFunction = nullptr;
+        function();
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostInterface::receiveEventCallback(UART_HandleTypeDef*)
+{
+    if (s_receiver)
+        s_receiver->m_rxHalfCount = s_receiver->m_rxHalfCount + 1;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Overrun, framing and noise errors abort the circular transfer, so it's restarted right away
+void HostInterface::errorCallback(UART_HandleTypeDef* huart)
+{
+    if (!s_receiver)
+        return;
+
+    // Fails if reception is still running, e.g. after a transmit error
+    if (HAL_UART_Receive_DMA(huart, s_receiver->m_rxBuffer.data(),
+                             s_receiver->m_rxBuffer.size()) != HAL_OK)
+        return;
+
+    s_receiver->m_rxHalfCount = 0;
+    s_receiver->m_rxRestarted = true;
 }
 
 // ---------------------------------------------------------------------------------------------- //
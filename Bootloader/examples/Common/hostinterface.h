@@ -37,6 +37,7 @@
 #include "string.h"
 
 #include <array>
+#include <bit>
 
 class HostInterface
 {
@@ -44,10 +45,24 @@ public:
     static constexpr const char* LineTerminator = "\r\n";
     static constexpr size_t LineTerminatorSize = 2;
 
+    // Largest request or response including its terminator, as given by Config::MaximumFrameSize
+    static constexpr size_t MaximumFrameSize = String::Capacity + LineTerminatorSize;
+
+    // Responses are queued here and sent back-to-back, one DMA transfer after the other
     static constexpr size_t TransmitBufferSize = 2048;
     static constexpr size_t MaximumStringSpanSize = TransmitBufferSize / String::Capacity;
 
-    static constexpr size_t ReceiveBufferSize = 256;
+    // Reception runs continuously into this ring buffer, so the host may send several requests
+    // back-to-back as long as they don't exceed its size before being processed. Data the DMA
+    // overwrote before it was processed is reported as an overflow.
+    static constexpr size_t ReceiveBufferSize = std::bit_ceil(3 * MaximumFrameSize);
+
+    static_assert(TransmitBufferSize >= 4 * MaximumFrameSize,
+                  "Transmit buffer too small for the frame size.");
+    static_assert(ReceiveBufferSize <= UINT16_MAX, "Receive buffer exceeds a single DMA transfer.");
+
+    // Called from the transmit complete interrupt, typically to reset the device
+    using SentFunction = void (*)();
 
     class Owner
     {
@@ -58,20 +73,52 @@ public:
 
 public:
     HostInterface(Owner* owner);
+    ~HostInterface();
 
     void update();
 
     void sendData(const String& data);
+    void callWhenSent(SentFunction function);
 
 private:
-    void restartReceive();
+    auto receivePosition() const -> size_t;
+
+    auto processData(const char* data, size_t size) -> size_t;
+    void appendData(const char* data, size_t size);
+    void discardData();
+
+    void queueData(const char* data, size_t size);
+    void startTransmit();
+    void transmitNext();
+
+    static void transmitCompleteCallback(UART_HandleTypeDef* huart);
+    static void receiveEventCallback(UART_HandleTypeDef* huart);
+    static void errorCallback(UART_HandleTypeDef* huart);
 
 private:
     Owner* m_owner;
+
     String m_currentData;
+    bool m_discardingData = false;
+
+    // Free-running count of bytes processed, the DMA's position is tracked by counting the half
+    // and full transfer interrupts, so that a lapped buffer can be told from an empty one
+    size_t m_readPosition = 0;
+    volatile size_t m_rxHalfCount = 0;
+    volatile bool m_rxRestarted = false;
+
+    // Free-running counters, the interrupt only advances the tail
+    size_t m_txHead = 0;
+    volatile size_t m_txTail = 0;
+    volatile size_t m_txCount = 0; // Size of the transfer in progress, zero if idle
 
-    std::array<uint8_t, String::Capacity> m_txBuffer = {};
-    std::array<uint8_t, String::Capacity> m_rxBuffer = {};
+    volatile SentFunction m_sentFunction = nullptr;
+
+    std::array<uint8_t, TransmitBufferSize> m_txBuffer = {};
+    std::array<uint8_t, ReceiveBufferSize> m_rxBuffer = {};
 
     UART_HandleTypeDef* m_handle = Config::HostInterfaceHandle;
+
+    static HostInterface* s_instance;
+    static HostInterface* s_receiver;
 };
@@ -35,11 +35,13 @@
 
 #include <algorithm>
 #include <array>
+#include <charconv>
 #include <cstdarg>
 #include <cstdlib>
 #include <cstring>
 #include <iterator>
 #include <span>
+#include <string_view>
 
 // ---------------------------------------------------------------------------------------------- //
 
@@ -49,6 +51,218 @@
 
 // ---------------------------------------------------------------------------------------------- //
 
+// Non-owning view of a character sequence, e.g. a token within a StaticString. It doesn't
+// include a null terminator, so it must not be passed to C string functions.
+class StaticStringView
+{
+public:
+    using value_type      = char;
+    using size_type       = size_t;
+    using difference_type = ptrdiff_t;
+    using const_reference = const value_type&;
+    using const_pointer   = const value_type*;
+    using const_iterator  = const_pointer;
+    using iterator        = const_iterator;
+
+    class TokenIterator;
+    class TokenRange;
+
+public:
+    constexpr StaticStringView() = default;
+    constexpr StaticStringView(const char* data, size_t size) : m_data(data), m_size(size) {}
+    constexpr StaticStringView(const char* string)
+        : m_data(string), m_size(std::char_traits<char>::length(string)) {}
+
+    constexpr auto operator==(StaticStringView other) const -> bool;
+
+    constexpr auto startsWith(StaticStringView string) const -> bool;
+    constexpr auto endsWith(StaticStringView string) const -> bool;
+
+    constexpr auto mid(size_t first, size_t count) const -> StaticStringView;
+
+    // Splits into tokens in a single pass, keeping empty ones between adjacent separators
+    constexpr auto tokens(char separator) const -> TokenRange;
+
+    // Decimal or, if prefixed by "0x", hexadecimal numbers. Returns zero if there is no number.
+    auto toULong() const -> unsigned long;
+
+    constexpr auto operator[](size_t n) const noexcept -> const char& { return m_data[n]; }
+
+    constexpr auto data() const noexcept -> const char* { return m_data; }
+    constexpr auto size() const -> size_t { return m_size; }
+    constexpr auto empty() const -> bool { return m_size == 0; }
+
+    constexpr auto begin() const -> const char* { return m_data; }
+    constexpr auto end() const -> const char* { return m_data + m_size; }
+
+    constexpr auto cbegin() const -> const char* { return m_data; }
+    constexpr auto cend() const -> const char* { return m_data + m_size; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+class StaticStringView::TokenIterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = StaticStringView;
+    using difference_type   = ptrdiff_t;
+    using pointer           = const StaticStringView*;
+    using reference         = const StaticStringView&;
+
+public:
+    constexpr TokenIterator() = default; // End of any token sequence
+    constexpr TokenIterator(StaticStringView string, char separator);
+
+    constexpr auto operator*() const -> reference { return m_token; }
+    constexpr auto operator->() const -> pointer { return &m_token; }
+
+    constexpr auto operator++() -> TokenIterator&;
+    constexpr auto operator++(int) -> TokenIterator;
+
+    constexpr auto operator==(const TokenIterator& other) const -> bool;
+
+private:
+    constexpr void findEnd(const char* begin);
+
+private:
+    StaticStringView m_token;
+    const char* m_end = nullptr; // End of the whole string
+    char m_separator = '\0';
+    bool m_valid = false;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+class StaticStringView::TokenRange
+{
+public:
+    constexpr TokenRange(StaticStringView string, char separator)
+        : m_string(string), m_separator(separator) {}
+
+    constexpr auto begin() const -> TokenIterator { return { m_string, m_separator }; }
+    constexpr auto end() const -> TokenIterator { return {}; }
+
+private:
+    StaticStringView m_string;
+    char m_separator;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr auto StaticStringView::operator==(StaticStringView other) const -> bool
+{
+    return std::equal(begin(), end(), other.begin(), other.end());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr auto StaticStringView::startsWith(StaticStringView string) const -> bool
+{
+    return string.m_size <= m_size && mid(0, string.m_size) == string;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr auto StaticStringView::endsWith(StaticStringView string) const -> bool
+{
+    return string.m_size <= m_size && mid(m_size - string.m_size, string.m_size) == string;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr auto StaticStringView::mid(size_t first, size_t count) const -> StaticStringView
+{
+    first = std::min(first, m_size);
+    count = std::min(count, m_size - first);
+
+    return { m_data + first, count };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr auto StaticStringView::tokens(char separator) const -> TokenRange
+{
+    return { *this, separator };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+inline auto StaticStringView::toULong() const -> unsigned long
+{
+    const char* first = begin();
+    int base = 10;
+
+    if (m_size > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X'))
+    {
+        first += 2;
+        base = 16;
+    }
+
+    unsigned long value = 0;
+    std::from_chars(first, end(), value, base);
+
+    return value;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr StaticStringView::TokenIterator::TokenIterator(StaticStringView string, char separator)
+    : m_end(string.end()),
+      m_separator(separator),
+      m_valid(true)
+{
+    findEnd(string.begin());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr auto StaticStringView::TokenIterator::operator++() -> TokenIterator&
+{
+    // The last token ends at the end of the string rather than at a separator
+    if (m_token.end() == m_end)
+        m_valid = false;
+    else
+        findEnd(m_token.end() + 1);
+
+    return *this;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr auto StaticStringView::TokenIterator::operator++(int) -> TokenIterator
+{
+    TokenIterator result = *this;
+    ++*this;
+
+    return result;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr auto StaticStringView::TokenIterator::operator==(const TokenIterator& other) const
+    -> bool
+{
+    if (!m_valid || !other.m_valid)
+        return m_valid == other.m_valid;
+
+    return m_token.begin() == other.m_token.begin();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr void StaticStringView::TokenIterator::findEnd(const char* begin)
+{
+    const char* end = std::find(begin, m_end, m_separator);
+    m_token = { begin, static_cast<size_t>(end - begin) };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 template <size_t N>
 class StaticString
 {
@@ -81,6 +295,7 @@ public:
     StaticString(StaticString&& other) noexcept;
     StaticString(const char* string);
     StaticString(const char* string, size_t first, size_t last);
+    explicit StaticString(StaticStringView view);
     ~StaticString() noexcept = default;
 
     auto format(const char* format, ...) -> StaticString&;
@@ -94,6 +309,8 @@ public:
     auto operator+=(const StaticString& other) -> StaticString&;
     auto operator+=(char c) -> StaticString&;
 
+    auto append(const char* data, size_t size) -> StaticString&;
+
     auto operator==(const StaticString& other) const -> bool;
     auto operator==(const char* other) const -> bool;
 
@@ -119,6 +336,9 @@ public:
     auto getAllTokens(char separator, std::span<StaticString> tokens,
                       TokenBehavior behavior = DefaultTokenBehavior) const -> size_t;
 
+    // Unlike the functions above, this neither copies the tokens nor rescans the string
+    auto tokens(char separator) const -> StaticStringView::TokenRange;
+
     auto toInt() const -> int;
     auto toUInt() const -> unsigned int;
     auto toLong() const -> long;
@@ -160,6 +380,8 @@ public:
     constexpr auto crbegin() const -> const char* { return m_data.cbegin() + m_size - 1; }
     constexpr auto crend() const -> const char* { return m_data.cbegin() - 1; }
 
+    constexpr operator StaticStringView() const { return { m_data.data(), m_size }; }
+
     static auto makeFormat(const char* format, ...) -> StaticString;
 
 private:
@@ -235,6 +457,18 @@ StaticString<N>::StaticString(const char* string, size_t first, size_t last)
 
 // ---------------------------------------------------------------------------------------------- //
 
+template <size_t N>
+StaticString<N>::StaticString(StaticStringView view)
+{
+    ASSERT(view.size() <= N);
+
+    m_size = std::min(view.size(), N);
+    std::copy_n(view.data(), m_size, m_data.begin());
+    m_data[m_size] = '\0';
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 template <size_t N>
 auto StaticString<N>::format(const char* format, ...) -> StaticString&
 {
@@ -324,6 +558,20 @@ auto StaticString<N>::operator+=(char c) -> StaticString&
 
 // ---------------------------------------------------------------------------------------------- //
 
+template <size_t N>
+auto StaticString<N>::append(const char* data, size_t size) -> StaticString&
+{
+    ASSERT(m_size + size <= N);
+
+    std::copy_n(data, size, std::begin(m_data) + m_size);
+    m_size += size;
+    m_data[m_size] = '\0';
+
+    return *this;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 template <size_t N>
 auto StaticString<N>::operator==(const StaticString& other) const -> bool
 {
@@ -571,6 +819,14 @@ auto StaticString<N>::getAllTokens(char separator, std::span<StaticString> token
 
 // ---------------------------------------------------------------------------------------------- //
 
+template <size_t N>
+auto StaticString<N>::tokens(char separator) const -> StaticStringView::TokenRange
+{
+    return StaticStringView(*this).tokens(separator);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 template <size_t N>
 auto StaticString<N>::toInt() const -> int
 {
@@ -31,6 +31,8 @@
 //                                                                                                //
 // ============================================================================================== //
 
+#include "config.h"
 #include "staticstring.h"
 
-using String = StaticString<80>;
+// Holds a complete request or response line
+using String = StaticString<Config::MaximumFrameSize>;
@@ -0,0 +1,77 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "staticstring.h"
+
+#include <cstdint>
+#include <span>
+
+// Lets the host retransmit a write request whose acknowledgement got lost, without the data
+// being programmed a second time. Retransmissions repeat the sequence number of the request.
+class WriteSequencer
+{
+public:
+    // Passes the data to the function unless the sequence number repeats that of the last
+    // request written successfully. Requests without a sequence number are always written
+    // (legacy hosts). Whatever the function throws is passed on, the request isn't recorded then.
+    template <typename Function>
+    void write(StaticStringView data, StaticStringView sequence, Function&& function);
+
+    // Called whenever a new image is started, whose sequence numbers start over
+    void reset() { m_lastSequenceValid = false; }
+
+private:
+    uint32_t m_lastSequence = 0;
+    bool m_lastSequenceValid = false;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+template <typename Function>
+void WriteSequencer::write(StaticStringView data, StaticStringView sequence, Function&& function)
+{
+    const bool sequenced = !sequence.empty();
+    const uint32_t number = sequenced ? sequence.toULong() : 0;
+
+    if (sequenced && m_lastSequenceValid && number == m_lastSequence)
+        return;
+
+    function(std::span<const char>(data.data(), data.size()));
+
+    m_lastSequence = number;
+    m_lastSequenceValid = sequenced;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -32,18 +32,57 @@
 // ============================================================================================== //
 
 #include "application.h"
+#include "bootmanager.h"
+#include "hexrecord.h"
 #include "main.h"
 
 // ---------------------------------------------------------------------------------------------- //
 
 namespace {
-    constexpr char TokenSeparator = ' ';
+    // Toolchains usually emit 16-byte records, which must fit into a frame along with the tag
+    // and the largest sequence number
+    constexpr size_t RecordRequestSize = sizeof("<WRITE_HEX_RECORD> ") - 1
+                                         + HexRecord::StringOverhead + 2 * 16
+                                         + sizeof(" 4294967295") - 1;
+
+    static_assert(RecordRequestSize <= Config::MaximumFrameSize,
+                  "Frame size too small for 16-byte records.");
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
+// Data records are by far the most frequent requests, but all commands dispatch equally fast
+const Application::Commands Application::s_commands = {{
+    { "<GET_BOOT_MODE>",                 &Application::protocolGetBootMode               },
+    { "<GET_BOARD_NAME>",                &Application::protocolGetBoardName              },
+    { "<GET_HARDWARE_VERSION>",          &Application::protocolGetHardwareVersion        },
+    { "<GET_BOOTLOADER_VERSION>",        &Application::protocolGetBootloaderVersion      },
+    { "<GET_SECTOR_COUNT>",              &Application::protocolGetSectorCount            },
+    { "<GET_FIRMWARE_VALID>",            &Application::protocolGetFirmwareValid          },
+    { "<GET_FIRMWARE_START_ADDRESS>",    &Application::protocolGetFirmwareStartAddress   },
+    { "<GET_FIRMWARE_END_ADDRESS>",      &Application::protocolGetFirmwareEndAddress     },
+    { "<GET_WORD_SIZE>",                 &Application::protocolGetWordSize               },
+    { "<GET_ERASE_ON_WRITE>",            &Application::protocolGetEraseOnWrite           },
+    { "<GET_FRAME_SIZE>",                &Application::protocolGetFrameSize              },
+    { "<GET_BLOCK_SIZE>",                &Application::protocolGetBlockSize              },
+    { "<GET_SECTOR_SIZE>",         1, 1, &Application::protocolGetSectorSize             },
+    { "<LAUNCH_FIRMWARE>",               &Application::protocolLaunchFirmware            },
+    { "<UNLOCK_FIRMWARE>",               &Application::protocolUnlockFirmware            },
+    { "<LOCK_FIRMWARE>",                 &Application::protocolLockFirmware              },
+    { "<ERASE_SECTOR>",            1, 1, &Application::protocolEraseSector               },
+    { "<ERASE_RANGE>",             2, 2, &Application::protocolEraseRange                },
+    { "<WRITE_HEX_RECORD>",        1, 2, &Application::protocolWriteHexRecord            },
+    { "<WRITE_COMPRESSED_BLOCK>",  1, 2, &Application::protocolWriteCompressedBlock      },
+    { "<BEGIN_PATCH>",             3, 3, &Application::protocolBeginPatch                },
+    { "<WRITE_PATCH_BLOCK>",       1, 2, &Application::protocolWritePatchBlock           },
+    { "<FINISH_PATCH>",                  &Application::protocolFinishPatch               }
+}};
+
+// ---------------------------------------------------------------------------------------------- //
+
 Application::Application()
-    : m_hostInterface(this) {}
+    : m_bootloader(this),
+      m_hostInterface(this) {}
 
 // ---------------------------------------------------------------------------------------------- //
 
@@ -59,49 +98,19 @@ void Application::exec()
 
 void Application::onHostDataReceived(const String& data)
 {
-    const size_t tokenCount = data.getTokenCount(TokenSeparator);
-
-    if (tokenCount < 1)
-        return;
-
-    const String tag = data.getToken(TokenSeparator, 0);
-
-    if (tag == "<GET_BOOT_MODE>")
-        protocolGetBootMode();
-    else if (tag == "<GET_BOARD_NAME>")
-        protocolGetBoardName();
-    else if (tag == "<GET_HARDWARE_VERSION>")
-        protocolGetHardwareVersion();
-    else if (tag == "<GET_BOOTLOADER_VERSION>")
-        protocolGetBootloaderVersion();
-    else if (tag == "<GET_SECTOR_COUNT>")
-        protocolGetSectorCount();
-    else if (tag == "<GET_FIRMWARE_VALID>")
-        protocolGetFirmwareValid();
-    else if (tag == "<LAUNCH_FIRMWARE>")
-        protocolLaunchFirmware();
-    else if (tag == "<UNLOCK_FIRMWARE>")
-        protocolUnlockFirmware();
-    else if (tag == "<LOCK_FIRMWARE>")
-        protocolLockFirmware();
-    else if (tag == "<ERASE_SECTOR>" || tag == "<WRITE_HEX_RECORD>")
+    switch (s_commands.dispatch(this, data))
     {
-        if (tokenCount < 2)
-            return sendError("MISSING_PARAMETER");
-
-        if (tag == "<ERASE_SECTOR>")
-        {
-            const String sector = data.getToken(TokenSeparator, 1);
-            protocolEraseSector(sector);
-        }
-        else if (tag == "<WRITE_HEX_RECORD>")
-        {
-            const String record = data.getToken(TokenSeparator, 1);
-            protocolWriteHexRecord(record);
-        }
-    }
-    else
+    case Commands::Result::Handled:
+        break;
+
+    case Commands::Result::UnknownCommand:
         sendError("UNKNOWN_COMMAND");
+        break;
+
+    case Commands::Result::MissingParameter:
+        sendError("MISSING_PARAMETER");
+        break;
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -113,6 +122,14 @@ void Application::onHostDataOverflow()
 
 // ---------------------------------------------------------------------------------------------- //
 
+// Erasing delays the response by up to seconds per sector, so tell the host to keep waiting
+void Application::onSectorErase(size_t sector)
+{
+    sendResponse("<ERASING>", String::makeFormat("%u", static_cast<unsigned>(sector)));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void Application::protocolGetBootMode()
 {
     sendResponse("<BOOT_MODE> BOOTLOADER");
@@ -156,15 +173,76 @@ void Application::protocolGetFirmwareValid()
 
 // ---------------------------------------------------------------------------------------------- //
 
+void Application::protocolGetFirmwareStartAddress()
+{
+    const auto address = static_cast<unsigned long>(m_bootloader.info().firmwareStartAddress);
+    sendResponse("<FIRMWARE_START_ADDRESS>", String::makeFormat("0x%08lx", address));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolGetFirmwareEndAddress()
+{
+    const auto address = static_cast<unsigned long>(m_bootloader.info().firmwareEndAddress);
+    sendResponse("<FIRMWARE_END_ADDRESS>", String::makeFormat("0x%08lx", address));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolGetWordSize()
+{
+    const auto size = static_cast<unsigned long>(m_bootloader.info().wordSize);
+    sendResponse("<WORD_SIZE>", String::makeFormat("%lu", size));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolGetEraseOnWrite()
+{
+    const char* eraseOnWrite = m_bootloader.info().eraseOnWrite ? "1" : "0";
+    sendResponse("<ERASE_ON_WRITE>", eraseOnWrite);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolGetFrameSize()
+{
+    const auto size = static_cast<unsigned long>(Config::MaximumFrameSize);
+    sendResponse("<FRAME_SIZE>", String::makeFormat("%lu", size));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolGetBlockSize()
+{
+    const auto size = static_cast<unsigned long>(m_bootloader.info().blockSize);
+    sendResponse("<BLOCK_SIZE>", String::makeFormat("%lu", size));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolGetSectorSize(Arguments arguments)
+{
+    const auto sector = arguments[0].toULong();
+
+    if (sector >= m_bootloader.info().sectorCount)
+        return sendError("INVALID_SECTOR");
+
+    const auto size = static_cast<unsigned long>(m_bootloader.info().sectorSizes[sector]) * 1024;
+    sendResponse("<SECTOR_SIZE>", String::makeFormat("%lu", size));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void Application::protocolLaunchFirmware()
 {
     if (!m_bootloader.getFirmwareValid())
         return sendError("INVALID_FIRMWARE");
 
+    m_bootloader.lockFirmware();
     sendResponse("<OK>");
 
-    HAL_Delay(500); // Give host time to receive response and disconnect
-    m_bootloader.launchFirmware();
+    m_hostInterface.callWhenSent([] { BootManager::reboot(BootManager::Mode::Firmware); });
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -173,6 +251,8 @@ void Application::protocolUnlockFirmware()
 {
     try {
         m_bootloader.unlockFirmware();
+        m_sequencer.reset();
+
         sendResponse("<OK>");
     }
     catch (const std::exception& e) {
@@ -195,9 +275,9 @@ void Application::protocolLockFirmware()
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Application::protocolEraseSector(const String& data)
+void Application::protocolEraseSector(Arguments arguments)
 {
-    const auto sector = data.toULong();
+    const auto sector = arguments[0].toULong();
 
     try {
         m_bootloader.eraseSector(sector);
@@ -210,10 +290,11 @@ void Application::protocolEraseSector(const String& data)
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Application::protocolWriteHexRecord(const String& data)
+// Each sector is announced by an <ERASING> notification before the final response
+void Application::protocolEraseRange(Arguments arguments)
 {
     try {
-        m_bootloader.writeHexRecord(data.c_str());
+        m_bootloader.eraseSectors(arguments[0].toULong(), arguments[1].toULong());
         sendResponse("<OK>");
     }
     catch (const std::exception& e) {
@@ -223,12 +304,88 @@ void Application::protocolWriteHexRecord(const String& data)
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Application::sendResponse(const String& tag, const String& data)
+void Application::protocolWriteHexRecord(Arguments arguments)
+{
+    writeSequenced(arguments, &Bootloader::writeHexRecord);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolWriteCompressedBlock(Arguments arguments)
+{
+    writeSequenced(arguments, &Bootloader::writeCompressedBlock);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Checks the source image and invalidates it, so this may take a moment
+void Application::protocolBeginPatch(Arguments arguments)
+{
+    try {
+        m_bootloader.beginPatch(arguments[0].toULong(), arguments[1].toULong(),
+                                arguments[2].toULong());
+        m_sequencer.reset();
+
+        sendResponse("<OK>");
+    }
+    catch (const std::exception& e) {
+        sendError(e.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Blocks entering a new sector are preceded by <ERASING> notifications for its backup
+void Application::protocolWritePatchBlock(Arguments arguments)
+{
+    writeSequenced(arguments, &Bootloader::writePatchBlock);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolFinishPatch()
+{
+    try {
+        m_bootloader.finishPatch();
+        sendResponse("<OK>");
+    }
+    catch (const std::exception& e) {
+        sendError(e.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::writeSequenced(Arguments arguments, WriteFunction write)
+{
+    const StaticStringView sequence = (arguments.size() > 1) ? arguments[1] : StaticStringView();
+
+    // Data may still be buffered when acknowledged, until its row of flash is complete. Errors
+    // writing it are reported for the request that flushes the row, at the latest at the end
+    // of file, so an upload has only succeeded once the image has been committed.
+    try {
+        m_sequencer.write(arguments[0], sequence, [&](std::span<const char> data) {
+            (m_bootloader.*write)(data);
+        });
+
+        sendResponse("<OK>", sequence);
+    }
+    catch (const std::exception& e) {
+        sendError(e.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::sendResponse(const String& tag, StaticStringView data)
 {
     auto response = tag;
 
     if (!data.empty())
-        response += " " + data;
+    {
+        response += ' ';
+        response.append(data.data(), data.size());
+    }
 
     m_hostInterface.sendData(response);
 }
@@ -34,9 +34,11 @@
 #pragma once
 
 #include "bootloader.h"
+#include "commandtable.h"
 #include "hostinterface.h"
+#include "writesequencer.h"
 
-class Application : public HostInterface::Owner
+class Application : public HostInterface::Owner, public Bootloader::Owner
 {
 public:
     Application();
@@ -44,9 +46,14 @@ public:
     void exec();
 
 private:
+    using Commands = CommandTable<Application, 23>;
+    using Arguments = Commands::Arguments;
+
     void onHostDataReceived(const String& data) override;
     void onHostDataOverflow() override;
 
+    void onSectorErase(size_t sector) override;
+
     void protocolGetBootMode();
 
     void protocolGetBoardName();
@@ -54,19 +61,38 @@ private:
     void protocolGetBootloaderVersion();
     void protocolGetSectorCount();
     void protocolGetFirmwareValid();
+    void protocolGetFirmwareStartAddress();
+    void protocolGetFirmwareEndAddress();
+    void protocolGetWordSize();
+    void protocolGetEraseOnWrite();
+    void protocolGetFrameSize();
+    void protocolGetBlockSize();
+    void protocolGetSectorSize(Arguments arguments);
 
     void protocolLaunchFirmware();
 
     void protocolUnlockFirmware();
     void protocolLockFirmware();
 
-    void protocolEraseSector(const String& data);
-    void protocolWriteHexRecord(const String& data);
+    void protocolEraseSector(Arguments arguments);
+    void protocolEraseRange(Arguments arguments);
+    void protocolWriteHexRecord(Arguments arguments);
+    void protocolWriteCompressedBlock(Arguments arguments);
+
+    void protocolBeginPatch(Arguments arguments);
+    void protocolWritePatchBlock(Arguments arguments);
+    void protocolFinishPatch();
 
-    void sendResponse(const String& tag, const String& data = {});
+    using WriteFunction = void (Bootloader::*)(std::span<const char>);
+    void writeSequenced(Arguments arguments, WriteFunction write);
+
+    void sendResponse(const String& tag, StaticStringView data = {});
     void sendError(const String& error);
 
 private:
     Bootloader m_bootloader;
     HostInterface m_hostInterface;
+    WriteSequencer m_sequencer;
+
+    static const Commands s_commands;
 };
@@ -0,0 +1 @@
+../../../bootloader/base64.cpp
\ No newline at end of file
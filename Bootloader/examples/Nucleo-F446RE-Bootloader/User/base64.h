@@ -0,0 +1 @@
+../../../bootloader/base64.h
\ No newline at end of file
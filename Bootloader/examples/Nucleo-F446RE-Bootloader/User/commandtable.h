@@ -0,0 +1 @@
+../../Common/commandtable.h
\ No newline at end of file
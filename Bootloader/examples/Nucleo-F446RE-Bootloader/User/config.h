@@ -33,6 +33,8 @@
 
 #pragma once
 
+#include "crcengine.h"
+#include "flashlayout.h"
 #include "main.h"
 
 extern UART_HandleTypeDef huart2;
@@ -45,13 +47,12 @@ namespace Config {
     constexpr uint32_t RamStartAddress = 0x20000004;
     constexpr uint32_t RamEndAddress   = 0x20020000;
 
-    constexpr uint32_t FirmwareStartSector = 2;
-    constexpr uint32_t FirmwareSectorCount = 2;
-
-    constexpr uint32_t FirmwareStartAddress = 0x08008000;
-    constexpr uint32_t FirmwareEndAddress   = 0x08010000 - sizeof(uint32_t);
-
-    constexpr uint32_t ChecksumAddress = FirmwareEndAddress;
+    constexpr CrcEngine ChecksumEngine = CrcEngine::Hardware;
 
     constexpr UART_HandleTypeDef* HostInterfaceHandle = &huart2;
+
+    // Longest request or response line, excluding its terminator. Sizes the host interface
+    // buffers and the longest hex record accepted. Larger frames allow longer records per
+    // request at the cost of RAM.
+    constexpr size_t MaximumFrameSize = 80;
 }
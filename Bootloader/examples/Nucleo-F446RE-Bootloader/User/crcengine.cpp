@@ -0,0 +1 @@
+../../../bootloader/crcengine.cpp
\ No newline at end of file
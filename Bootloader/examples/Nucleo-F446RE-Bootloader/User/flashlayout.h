@@ -0,0 +1,60 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <cstdint>
+
+// Shared by the bootloader and the firmware, which stages updates into the bootloader's slots.
+// Must match the memory regions of both linker scripts, see MemoryMap.txt.
+namespace Config {
+    constexpr uint32_t FlashBaseAddress = 0x08000000;
+    constexpr uint32_t FlashSectorSizes[] = { 16, 16, 16, 16, 64, 128, 128, 128 }; // KiB
+
+    constexpr uint32_t FirmwareStartSector = 2;
+    constexpr uint32_t FirmwareSectorCount = 2;
+
+    constexpr uint32_t FirmwareStartAddress = 0x08008000;
+    constexpr uint32_t FirmwareEndAddress   = 0x08010000 - 2 * sizeof(uint32_t);
+
+    constexpr uint32_t ChecksumAddress = FirmwareEndAddress;
+
+    constexpr uint32_t StagingStartSector = 4;
+    constexpr uint32_t StagingSectorCount = 1;
+
+    constexpr uint32_t StagingStartAddress = 0x08010000;
+    constexpr uint32_t StagingEndAddress   = 0x08020000 - 2 * sizeof(uint32_t);
+
+    constexpr uint32_t ScratchSector  = 5;
+    constexpr uint32_t ScratchAddress = 0x08020000;
+}
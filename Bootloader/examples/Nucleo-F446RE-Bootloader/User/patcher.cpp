@@ -0,0 +1 @@
+../../../bootloader/patcher.cpp
\ No newline at end of file
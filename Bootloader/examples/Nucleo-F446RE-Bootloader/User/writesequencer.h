@@ -0,0 +1 @@
+../../Common/writesequencer.h
\ No newline at end of file
@@ -37,8 +37,6 @@
 // ---------------------------------------------------------------------------------------------- //
 
 namespace {
-    constexpr char TokenSeparator = ' ';
-
     constexpr uint32_t BootloaderMagic = 0xdeadbeef;
     volatile uint32_t g_bootloaderMagic __attribute__((section(".bootflags")));
 }
@@ -47,10 +45,29 @@ namespace {
 
 Application* Application::s_instance = nullptr;
 
+// Updates are staged with the same commands the bootloader uses for programming
+const Application::Commands Application::s_commands = {{
+    { "<GET_BOOT_MODE>",               &Application::protocolGetBootMode               },
+    { "<GET_BOARD_NAME>",              &Application::protocolGetBoardName              },
+    { "<GET_HARDWARE_VERSION>",        &Application::protocolGetHardwareVersion        },
+    { "<GET_FIRMWARE_VERSION>",        &Application::protocolGetFirmwareVersion        },
+    { "<GET_SECTOR_COUNT>",            &Application::protocolGetSectorCount            },
+    { "<GET_FRAME_SIZE>",              &Application::protocolGetFrameSize              },
+    { "<GET_STAGED_FIRMWARE_VALID>",   &Application::protocolGetStagedFirmwareValid    },
+    { "<LAUNCH_BOOTLOADER>",           &Application::protocolLaunchBootloader          },
+    { "<INSTALL_FIRMWARE>",            &Application::protocolInstallFirmware           },
+    { "<UNLOCK_FIRMWARE>",             &Application::protocolUnlockFirmware            },
+    { "<LOCK_FIRMWARE>",               &Application::protocolLockFirmware              },
+    { "<ERASE_SECTOR>",          1, 1, &Application::protocolEraseSector               },
+    { "<ERASE_RANGE>",           2, 2, &Application::protocolEraseRange                },
+    { "<WRITE_HEX_RECORD>",      1, 2, &Application::protocolWriteHexRecord            }
+}};
+
 // ---------------------------------------------------------------------------------------------- //
 
 Application::Application()
-    : m_hostInterface(this)
+    : m_stager(this),
+      m_hostInterface(this)
 {
     s_instance = this;
 }
@@ -78,25 +95,19 @@ void Application::exec()
 
 void Application::onHostDataReceived(const String& data)
 {
-    const size_t tokenCount = data.getTokenCount(TokenSeparator);
-
-    if (tokenCount < 1)
-        return;
-
-    const String tag = data.getToken(TokenSeparator, 0);
+    switch (s_commands.dispatch(this, data))
+    {
+    case Commands::Result::Handled:
+        break;
 
-    if (tag == "<GET_BOOT_MODE>")
-        protocolGetBootMode();
-    else if (tag == "<GET_BOARD_NAME>")
-        protocolGetBoardName();
-    else if (tag == "<GET_HARDWARE_VERSION>")
-        protocolGetHardwareVersion();
-    else if (tag == "<GET_FIRMWARE_VERSION>")
-        protocolGetFirmwareVersion();
-    else if (tag == "<LAUNCH_BOOTLOADER>")
-        protocolLaunchBootloader();
-    else
+    case Commands::Result::UnknownCommand:
         sendError("UNKNOWN_COMMAND");
+        break;
+
+    case Commands::Result::MissingParameter:
+        sendError("MISSING_PARAMETER");
+        break;
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -108,6 +119,14 @@ void Application::onHostDataOverflow()
 
 // ---------------------------------------------------------------------------------------------- //
 
+// Erasing stalls the CPU on single-bank devices, so tell the host to keep waiting
+void Application::onSectorErase(size_t sector)
+{
+    sendResponse("<ERASING>", String::makeFormat("%u", static_cast<unsigned>(sector)));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void Application::protocolGetBootMode()
 {
     sendResponse("<BOOT_MODE> FIRMWARE");
@@ -136,24 +155,135 @@ void Application::protocolGetFirmwareVersion()
 
 // ---------------------------------------------------------------------------------------------- //
 
+void Application::protocolGetSectorCount()
+{
+    const auto count = static_cast<unsigned long>(m_stager.info().sectorCount);
+    sendResponse("<SECTOR_COUNT>", String::makeFormat("%lu", count));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolGetFrameSize()
+{
+    const auto size = static_cast<unsigned long>(Config::MaximumFrameSize);
+    sendResponse("<FRAME_SIZE>", String::makeFormat("%lu", size));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolGetStagedFirmwareValid()
+{
+    const char* valid = m_stager.getImageValid() ? "1" : "0";
+    sendResponse("<STAGED_FIRMWARE_VALID>", valid);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void Application::protocolLaunchBootloader()
 {
     sendResponse("<OK>");
 
-    HAL_Delay(500); // Give host time to receive response and disconnect
+    m_hostInterface.callWhenSent([] {
+        g_bootloaderMagic = BootloaderMagic;
+        HAL_NVIC_SystemReset();
+    });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// The bootloader installs the staged image on reset and launches it right away
+void Application::protocolInstallFirmware()
+{
+    if (!m_stager.getImageValid())
+        return sendError("STAGED_FIRMWARE_INVALID");
+
+    m_stager.lock();
+    sendResponse("<OK>");
+
+    m_hostInterface.callWhenSent([] {
+        g_bootloaderMagic = 0;
+        HAL_NVIC_SystemReset();
+    });
+}
+
+// ---------------------------------------------------------------------------------------------- //
 
-    g_bootloaderMagic = BootloaderMagic;
-    HAL_NVIC_SystemReset();
+void Application::protocolUnlockFirmware()
+{
+    try {
+        m_stager.unlock();
+        m_sequencer.reset();
+
+        sendResponse("<OK>");
+    }
+    catch (const std::exception& e) {
+        sendError(e.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolLockFirmware()
+{
+    m_stager.lock();
+    sendResponse("<OK>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolEraseSector(Arguments arguments)
+{
+    try {
+        m_stager.eraseSector(arguments[0].toULong());
+        sendResponse("<OK>");
+    }
+    catch (const std::exception& e) {
+        sendError(e.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolEraseRange(Arguments arguments)
+{
+    try {
+        m_stager.eraseSectors(arguments[0].toULong(), arguments[1].toULong());
+        sendResponse("<OK>");
+    }
+    catch (const std::exception& e) {
+        sendError(e.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Application::protocolWriteHexRecord(Arguments arguments)
+{
+    const StaticStringView sequence = (arguments.size() > 1) ? arguments[1] : StaticStringView();
+
+    try {
+        m_sequencer.write(arguments[0], sequence, [this](std::span<const char> record) {
+            m_stager.writeHexRecord(record);
+        });
+
+        sendResponse("<OK>", sequence);
+    }
+    catch (const std::exception& e) {
+        sendError(e.what());
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Application::sendResponse(const String& tag, const String& data)
+void Application::sendResponse(const String& tag, StaticStringView data)
 {
     auto response = tag;
 
     if (!data.empty())
-        response += " " + data;
+    {
+        response += ' ';
+        response.append(data.data(), data.size());
+    }
 
     m_hostInterface.sendData(response);
 }
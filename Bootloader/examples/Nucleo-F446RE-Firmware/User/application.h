@@ -33,9 +33,12 @@
 
 #pragma once
 
+#include "commandtable.h"
 #include "hostinterface.h"
+#include "stager.h"
+#include "writesequencer.h"
 
-class Application : public HostInterface::Owner
+class Application : public HostInterface::Owner, public Stager::Owner
 {
 public:
     Application();
@@ -44,18 +47,34 @@ public:
     void exec();
 
 private:
+    using Commands = CommandTable<Application, 14>;
+    using Arguments = Commands::Arguments;
+
     void onHostDataReceived(const String& data) override;
     void onHostDataOverflow() override;
 
+    void onSectorErase(size_t sector) override;
+
     void protocolGetBootMode();
 
     void protocolGetBoardName();
     void protocolGetHardwareVersion();
     void protocolGetFirmwareVersion();
+    void protocolGetSectorCount();
+    void protocolGetFrameSize();
+    void protocolGetStagedFirmwareValid();
 
     void protocolLaunchBootloader();
+    void protocolInstallFirmware();
+
+    void protocolUnlockFirmware();
+    void protocolLockFirmware();
+
+    void protocolEraseSector(Arguments arguments);
+    void protocolEraseRange(Arguments arguments);
+    void protocolWriteHexRecord(Arguments arguments);
 
-    void sendResponse(const String& tag, const String& data = {});
+    void sendResponse(const String& tag, StaticStringView data = {});
     void sendError(const String& error);
 
     void toggleLed();
@@ -63,8 +82,11 @@ private:
     static void timerElapsedCallback(TIM_HandleTypeDef* htim);
 
 private:
+    Stager m_stager;
     HostInterface m_hostInterface;
+    WriteSequencer m_sequencer;
     bool m_ledState = GPIO_PIN_RESET;
 
     static Application* s_instance;
+    static const Commands s_commands;
 };
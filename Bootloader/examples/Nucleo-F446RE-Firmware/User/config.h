@@ -33,6 +33,8 @@
 
 #pragma once
 
+#include "crcengine.h"
+#include "flashlayout.h"
 #include "main.h"
 
 extern TIM_HandleTypeDef htim1;
@@ -43,6 +45,11 @@ namespace Config {
     constexpr const char* HardwareVersion = "1.0";
     constexpr const char* FirmwareVersion = "1.0";
 
+    constexpr CrcEngine ChecksumEngine = CrcEngine::Hardware;
+
     constexpr TIM_HandleTypeDef* LedTimerHandle = &htim1;
     constexpr UART_HandleTypeDef* HostInterfaceHandle = &huart2;
+
+    // Longest request or response line, excluding its terminator
+    constexpr size_t MaximumFrameSize = 80;
 }
@@ -0,0 +1 @@
+../../../bootloader/crcengine.h
\ No newline at end of file
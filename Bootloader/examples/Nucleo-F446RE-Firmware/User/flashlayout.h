@@ -0,0 +1 @@
+../../Nucleo-F446RE-Bootloader/User/flashlayout.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../bootloader/hexrecord.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../bootloader/programmer.cpp
\ No newline at end of file
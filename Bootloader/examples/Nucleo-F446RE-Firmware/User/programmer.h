@@ -0,0 +1 @@
+../../../bootloader/programmer.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../bootloader/stager.h
\ No newline at end of file
@@ -0,0 +1,502 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+// Measures the per-record CPU cost of the bootloader's hot paths on the host. Instruction counts
+// carry over to the device far better than times, and make accidental quadratic behaviour
+// visible as counts growing faster than the record length.
+
+#include "application.h"
+#include "checksum.h"
+#include "crc32.h"
+#include "crcengine.h"
+#include "decompressor.h"
+#include "hexrecord.h"
+#include "perfcounters.h"
+#include "simulation.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------- //
+
+UART_HandleTypeDef huart2 = {};
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr auto MinimumDuration = std::chrono::milliseconds(200);
+
+    constexpr size_t RecordLengths[] = { 4, 8, 16, 32 };
+    constexpr size_t RecordCount = 256;
+
+    constexpr size_t CrcImageSizes[] = { 1024, 16384, 65536, 262144, 1048576 };
+
+    struct Result
+    {
+        double nanoseconds = 0.0;
+        double instructions = 0.0;
+        double cycles = 0.0;
+    };
+
+    // Receives frames without interpreting them, to separate reception from dispatch
+    class NullOwner : public HostInterface::Owner
+    {
+        void onHostDataReceived(const String&) override {}
+        void onHostDataOverflow() override {}
+    };
+
+    template <typename T>
+    inline void keep(const T& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // Calls the function in growing batches for at least MinimumDuration, returns cost per call
+    template <typename Function>
+    auto measure(PerfCounters& counters, Function&& function) -> Result
+    {
+        function(); // Warm-up
+
+        size_t iterations = 0;
+        size_t batch = 1;
+
+        Clock::duration elapsed = {};
+        PerfCounters::Sample total;
+
+        while (elapsed < MinimumDuration)
+        {
+            const auto start = Clock::now();
+            counters.start();
+
+            for (size_t i = 0; i < batch; ++i)
+                function();
+
+            const PerfCounters::Sample sample = counters.stop();
+            elapsed += Clock::now() - start;
+
+            total.instructions += sample.instructions;
+            total.cycles += sample.cycles;
+
+            iterations += batch;
+            batch *= 2;
+        }
+
+        return {
+            std::chrono::duration<double, std::nano>(elapsed).count() / iterations,
+            static_cast<double>(total.instructions) / iterations,
+            static_cast<double>(total.cycles) / iterations
+        };
+    }
+
+    void printHeader()
+    {
+        std::printf("%-40s %12s %14s %12s\n", "Benchmark", "Time [ns]", "Instructions", "Cycles");
+    }
+
+    void printResult(const PerfCounters& counters, const std::string& name, const Result& result)
+    {
+        if (counters.available())
+        {
+            std::printf("%-40s %12.1f %14.1f %12.1f\n",
+                        name.c_str(), result.nanoseconds, result.instructions, result.cycles);
+        }
+        else
+            std::printf("%-40s %12.1f %14s %12s\n", name.c_str(), result.nanoseconds, "-", "-");
+    }
+
+    auto makeRecord(uint8_t type, uint16_t address, const std::vector<uint8_t>& data)
+        -> std::string
+    {
+        static constexpr char Digits[] = "0123456789ABCDEF";
+
+        std::string record = ":";
+        uint8_t checksum = 0;
+
+        auto append = [&](uint8_t value) {
+            record += Digits[value >> 4];
+            record += Digits[value & 0x0f];
+            checksum += value;
+        };
+
+        append(static_cast<uint8_t>(data.size()));
+        append(static_cast<uint8_t>(address >> 8));
+        append(static_cast<uint8_t>(address));
+        append(type);
+
+        for (uint8_t value : data)
+            append(value);
+
+        append(static_cast<uint8_t>(-checksum));
+
+        return record;
+    }
+
+    auto makeDataRecord(size_t length, uint16_t address) -> std::string
+    {
+        std::vector<uint8_t> data(length);
+
+        for (size_t i = 0; i < length; ++i)
+            data[i] = static_cast<uint8_t>(address + i);
+
+        return makeRecord(0x00, address, data);
+    }
+
+    // Consecutive records in the first firmware sector, each with its own sequence number
+    auto makeFrames(size_t length) -> std::vector<std::string>
+    {
+        const uint16_t offset = Config::FirmwareStartAddress & 0xffff;
+
+        std::vector<std::string> frames;
+
+        for (size_t i = 0; i < RecordCount; ++i)
+        {
+            const std::string record = makeDataRecord(length, offset + i * length);
+            frames.push_back("<WRITE_HEX_RECORD> " + record + " " + std::to_string(i) + "\r\n");
+        }
+
+        return frames;
+    }
+
+    // Frames must fit into the bootloader's receive string, excluding the line terminator
+    auto frameFits(size_t length) -> bool
+    {
+        const std::string frame = makeFrames(length).back();
+        return frame.size() - HostInterface::LineTerminatorSize < String::Capacity;
+    }
+
+    void benchmarkHexRecord(PerfCounters& counters)
+    {
+        for (size_t length : RecordLengths)
+        {
+            const std::string record = makeDataRecord(length, 0);
+
+            const Result result = measure(counters, [&] {
+                keep(HexRecord::fromString(std::span(record)));
+            });
+
+            printResult(counters, "HexRecord::fromString/" + std::to_string(length), result);
+        }
+    }
+
+    template <CrcEngine Engine>
+    void benchmarkCrcEngine(PerfCounters& counters, const char* name,
+                            const std::vector<uint8_t>& image)
+    {
+        for (size_t size : CrcImageSizes)
+        {
+            const uint32_t expected = crc32_update_buffer(0, image.data(), size);
+            const uint32_t actual = Crc32::update<Engine>(0, image.data(), size);
+
+            if (actual != expected)
+                std::fprintf(stderr, "Warning: %s engine computes a wrong checksum\n", name);
+
+            const Result result = measure(counters, [&] {
+                keep(Crc32::update<Engine>(0, image.data(), size));
+            });
+
+            printResult(counters, "Crc32/" + std::string(name) + "/" + std::to_string(size / 1024)
+                                  + "K", result);
+        }
+    }
+
+    // Boot time is dominated by checksumming the image, which scales linearly with its size.
+    // The hardware engine runs on an emulated CRC unit and is only measured for completeness.
+    void benchmarkCrc(PerfCounters& counters)
+    {
+        std::vector<uint8_t> image(CrcImageSizes[std::size(CrcImageSizes) - 1]);
+
+        for (size_t i = 0; i < image.size(); ++i)
+            image[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+
+        benchmarkCrcEngine<CrcEngine::Bytewise>(counters, "Bytewise", image);
+        benchmarkCrcEngine<CrcEngine::Slicing4>(counters, "Slicing4", image);
+        benchmarkCrcEngine<CrcEngine::Slicing8>(counters, "Slicing8", image);
+        benchmarkCrcEngine<CrcEngine::Hardware>(counters, "Hardware", image);
+
+        const uint32_t partitionSize = Config::FirmwareEndAddress - Config::FirmwareStartAddress;
+
+        const Result result = measure(counters, [&] {
+            keep(Checksum::compute(Slot::Active, partitionSize));
+        });
+
+        printResult(counters, "Checksum::compute/" + std::to_string(partitionSize / 1024) + "K",
+                    result);
+    }
+
+    auto encodeBase64(const std::vector<uint8_t>& bytes) -> std::string
+    {
+        static constexpr char Alphabet[] =
+                "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string string;
+
+        for (size_t i = 0; i < bytes.size(); i += 3)
+        {
+            const size_t count = std::min<size_t>(3, bytes.size() - i);
+            uint32_t word = 0;
+
+            for (size_t j = 0; j < 3; ++j)
+                word = (word << 8) | (j < count ? bytes[i + j] : 0);
+
+            for (size_t j = 0; j < 4; ++j)
+                string += (j <= count) ? Alphabet[(word >> (18 - 6 * j)) & 0x3f] : '=';
+        }
+
+        return string;
+    }
+
+    auto makeBlock(const std::vector<uint8_t>& expanded, const std::vector<uint8_t>& data)
+        -> std::string
+    {
+        const uint32_t address = Config::FirmwareStartAddress;
+        const uint32_t length = expanded.size();
+
+        std::vector<uint8_t> block;
+
+        for (size_t i = 0; i < 4; ++i)
+            block.push_back(static_cast<uint8_t>(address >> (i*8)));
+
+        for (size_t i = 0; i < 2; ++i)
+            block.push_back(static_cast<uint8_t>(length >> (i*8)));
+
+        const uint32_t crc = crc32_update_buffer(crc32_update_buffer(0, block.data(), block.size()),
+                                                 expanded.data(), length);
+
+        for (size_t i = 0; i < 4; ++i)
+            block.push_back(static_cast<uint8_t>(crc >> (i*8)));
+
+        block.insert(block.end(), data.begin(), data.end());
+
+        return encodeBase64(block);
+    }
+
+    // Incompressible data is all literals, a fill pattern the longest possible matches. Both are
+    // sized to fit into a frame, so they bound the cost per decompressed byte from both sides.
+    void benchmarkDecompressor(PerfCounters& counters)
+    {
+        const size_t literalCount = (Decompressor::MaximumBlockSize - Decompressor::HeaderSize)
+                                    / 9 * 8;
+
+        std::vector<uint8_t> literals(literalCount);
+        std::vector<uint8_t> literalData;
+
+        for (size_t i = 0; i < literals.size(); ++i)
+        {
+            literals[i] = static_cast<uint8_t>(i * 7);
+
+            if (i % 8 == 0)
+                literalData.push_back(0xff);
+
+            literalData.push_back(literals[i]);
+        }
+
+        // One literal repeated by matches at distance 1 with the maximum length of 66
+        std::vector<uint8_t> fill(1 + 15 * 66, 0xa5);
+        std::vector<uint8_t> fillData = { 0x01, 0xa5 };
+
+        for (size_t i = 0; i < 15; ++i)
+        {
+            if (i == 7)
+                fillData.push_back(0x00);
+
+            fillData.insert(fillData.end(), { 0x00, 0x3f });
+        }
+
+        const struct {
+            const char* name;
+            std::string block;
+            size_t length;
+        } benchmarks[] = {
+            { "literals", makeBlock(literals, literalData), literals.size() },
+            { "fill", makeBlock(fill, fillData), fill.size() }
+        };
+
+        for (const auto& benchmark : benchmarks)
+        {
+            Decompressor decompressor;
+
+            const Result result = measure(counters, [&] {
+                keep(decompressor.decompress(std::span(benchmark.block)));
+            });
+
+            printResult(counters, "Decompressor/" + std::string(benchmark.name) + "/"
+                                  + std::to_string(benchmark.length), result);
+        }
+    }
+
+    void benchmarkString(PerfCounters& counters)
+    {
+        for (size_t length : RecordLengths)
+        {
+            if (!frameFits(length))
+                continue;
+
+            std::string frame = makeFrames(length).front();
+            frame.resize(frame.size() - HostInterface::LineTerminatorSize);
+
+            const String data = frame.c_str();
+
+            const Result result = measure(counters, [&] {
+                const size_t count = data.getTokenCount(' ');
+
+                for (size_t i = 0; i < count; ++i)
+                    keep(data.getToken(' ', i));
+            });
+
+            printResult(counters, "StaticString::getToken/" + std::to_string(length), result);
+
+            const Result viewResult = measure(counters, [&] {
+                for (StaticStringView token : data.tokens(' '))
+                    keep(token);
+            });
+
+            printResult(counters, "StaticString::tokens/" + std::to_string(length), viewResult);
+        }
+
+        unsigned long value = Config::FirmwareStartAddress;
+
+        const Result result = measure(counters, [&] {
+            keep(String::makeFormat("0x%08lx", value++));
+        });
+
+        printResult(counters, "StaticString::makeFormat", result);
+    }
+
+    void benchmarkReceive(PerfCounters& counters, Simulation::Uart& uart,
+                          HostInterface::Owner* owner, const std::string& name,
+                          const std::vector<std::string>& frames)
+    {
+        // Take over reception from any other host interface, e.g. the application's own
+        HAL_UART_AbortReceive(&huart2);
+
+        HostInterface hostInterface(owner);
+
+        size_t index = 0;
+        std::string response;
+
+        const Result result = measure(counters, [&] {
+            const std::string& frame = frames[index++ % frames.size()];
+
+            uart.write(reinterpret_cast<const uint8_t*>(frame.data()), frame.size());
+            hostInterface.update();
+
+            response = uart.takeOutput();
+        });
+
+        printResult(counters, name, result);
+
+        if (response.starts_with("<ERROR>"))
+            std::fprintf(stderr, "Warning: %s failed with %s", name.c_str(), response.c_str());
+    }
+
+    void benchmarkDispatch(PerfCounters& counters, Simulation::Uart& uart)
+    {
+        NullOwner nullOwner;
+        Application application;
+
+        const std::vector<std::string> queries = { "<GET_BOOT_MODE>\r\n" };
+
+        benchmarkReceive(counters, uart, &nullOwner, "HostInterface/query", queries);
+        benchmarkReceive(counters, uart, &application, "Application/query", queries);
+
+        benchmarkReceive(counters, uart, &application, "Application/unlock",
+                         { "<UNLOCK_FIRMWARE>\r\n" });
+
+        // Data records are relative to the upper address bits of the firmware partition
+        const uint32_t upperAddress = Config::FirmwareStartAddress >> 16;
+        const std::string address = makeRecord(0x04, 0, { uint8_t(upperAddress >> 8),
+                                                          uint8_t(upperAddress) });
+
+        benchmarkReceive(counters, uart, &application, "Application/address",
+                         { "<WRITE_HEX_RECORD> " + address + "\r\n" });
+
+        for (size_t length : RecordLengths)
+        {
+            if (!frameFits(length))
+                continue;
+
+            const std::vector<std::string> frames = makeFrames(length);
+            const std::string suffix = "/" + std::to_string(length);
+
+            benchmarkReceive(counters, uart, &nullOwner, "HostInterface/record" + suffix, frames);
+            benchmarkReceive(counters, uart, &application, "Application/record" + suffix, frames);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main() -> int
+{
+    Simulation::Flash::Settings flashSettings;
+    flashSettings.baseAddress = Config::FlashBaseAddress;
+
+    for (uint32_t size : Config::FlashSectorSizes)
+        flashSettings.sectorSizes.push_back(size * 1024);
+
+    Simulation::Uart::Settings uartSettings;
+    uartSettings.baudrate = 0;
+    uartSettings.transport = Simulation::Uart::Transport::Memory;
+
+    try {
+        Simulation::Flash flash(flashSettings);
+        Simulation::Uart uart(uartSettings);
+
+        uart.attach(&huart2);
+
+        PerfCounters counters;
+
+        if (!counters.available())
+            std::fprintf(stderr, "Hardware performance counters unavailable, reporting time only.\n");
+
+        printHeader();
+
+        benchmarkHexRecord(counters);
+        benchmarkCrc(counters);
+        benchmarkDecompressor(counters);
+        benchmarkString(counters);
+        benchmarkDispatch(counters, uart);
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,110 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "perfcounters.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    auto openCounter(uint64_t config, int group) -> int
+    {
+        perf_event_attr attr = {};
+
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = (group < 0);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+
+    auto readCounter(int fd) -> uint64_t
+    {
+        uint64_t value = 0;
+        return (read(fd, &value, sizeof(value)) == sizeof(value)) ? value : 0;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+PerfCounters::PerfCounters()
+{
+    // Both counters form a group, so they are always scheduled together
+    m_instructions = openCounter(PERF_COUNT_HW_INSTRUCTIONS, -1);
+
+    if (m_instructions >= 0)
+        m_cycles = openCounter(PERF_COUNT_HW_CPU_CYCLES, m_instructions);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+PerfCounters::~PerfCounters()
+{
+    if (m_cycles >= 0)
+        close(m_cycles);
+
+    if (m_instructions >= 0)
+        close(m_instructions);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void PerfCounters::start()
+{
+    if (!available())
+        return;
+
+    ioctl(m_instructions, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(m_instructions, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PerfCounters::stop() -> Sample
+{
+    if (!available())
+        return {};
+
+    ioctl(m_instructions, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    return { readCounter(m_instructions), readCounter(m_cycles) };
+}
+
+// ---------------------------------------------------------------------------------------------- //
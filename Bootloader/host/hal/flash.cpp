@@ -0,0 +1,255 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "simulation.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace Simulation;
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    Flash* g_instance = nullptr;
+
+    constexpr uint8_t ErasedValue = 0xff;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+Flash::Flash(const Settings& settings)
+    : m_settings(settings),
+      m_size(std::accumulate(settings.sectorSizes.begin(), settings.sectorSizes.end(), size_t(0)))
+{
+    if (g_instance)
+        throw std::logic_error("Only a single flash instance is supported.");
+
+    if (m_size == 0)
+        throw std::invalid_argument("No flash sectors specified.");
+
+    bool initialized = false;
+
+    if (m_settings.backingFile.empty())
+        m_file = memfd_create("flash", 0);
+    else
+    {
+        m_file = open(m_settings.backingFile.c_str(), O_RDWR | O_CREAT, 0644);
+
+        struct stat info = {};
+
+        if (m_file >= 0 && fstat(m_file, &info) == 0)
+            initialized = (static_cast<size_t>(info.st_size) == m_size);
+    }
+
+    if (m_file < 0)
+        throwSystemError("Unable to create flash memory");
+
+    if (ftruncate(m_file, m_size) < 0)
+        throwSystemError("Unable to resize flash memory");
+
+    m_memory = static_cast<uint8_t*>(mmap(nullptr, m_size, PROT_READ | PROT_WRITE,
+                                          MAP_SHARED, m_file, 0));
+    if (m_memory == MAP_FAILED)
+        throwSystemError("Unable to map flash memory");
+
+    // Read-only view at the physical address, so stray writes fault like on the real device
+    auto address = reinterpret_cast<void*>(uintptr_t(m_settings.baseAddress));
+    void* view = mmap(address, m_size, PROT_READ, MAP_SHARED | MAP_FIXED_NOREPLACE, m_file, 0);
+
+    if (view != address)
+    {
+        if (view != MAP_FAILED)
+            munmap(view, m_size);
+
+        munmap(m_memory, m_size);
+        throwSystemError("Unable to map flash memory to its physical address");
+    }
+
+    if (!initialized)
+        std::fill_n(m_memory, m_size, ErasedValue);
+
+    g_instance = this;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+Flash::~Flash()
+{
+    munmap(reinterpret_cast<void*>(uintptr_t(m_settings.baseAddress)), m_size);
+    munmap(m_memory, m_size);
+
+    close(m_file);
+
+    g_instance = nullptr;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Flash::reset()
+{
+    m_locked = true;
+    m_error = HAL_FLASH_ERROR_NONE;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Flash::unlock() -> HAL_StatusTypeDef
+{
+    m_locked = false;
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Flash::lock() -> HAL_StatusTypeDef
+{
+    m_locked = true;
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Flash::program(uint32_t typeProgram, uint32_t address, uint64_t data) -> HAL_StatusTypeDef
+{
+    m_error = HAL_FLASH_ERROR_NONE;
+
+    if (m_locked)
+    {
+        m_error = HAL_FLASH_ERROR_PGS;
+        return HAL_ERROR;
+    }
+
+    if (typeProgram > FLASH_TYPEPROGRAM_DOUBLEWORD)
+    {
+        m_error = HAL_FLASH_ERROR_PGP;
+        return HAL_ERROR;
+    }
+
+    const size_t size = size_t(1) << typeProgram;
+    const size_t offset = address - m_settings.baseAddress;
+
+    if (address < m_settings.baseAddress || offset + size > m_size || address % size != 0)
+    {
+        m_error = HAL_FLASH_ERROR_PGA;
+        return HAL_ERROR;
+    }
+
+    // Programming can only clear bits
+    for (size_t i = 0; i < size; ++i)
+        m_memory[offset + i] &= static_cast<uint8_t>(data >> (8*i));
+
+    wait(m_settings.programTime);
+
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Flash::erase(const FLASH_EraseInitTypeDef& eraseInit,
+                  uint32_t* sectorError) -> HAL_StatusTypeDef
+{
+    m_error = HAL_FLASH_ERROR_NONE;
+    *sectorError = 0xffffffff;
+
+    if (m_locked)
+    {
+        m_error = HAL_FLASH_ERROR_PGS;
+        return HAL_ERROR;
+    }
+
+    if (eraseInit.TypeErase == FLASH_TYPEERASE_MASSERASE)
+    {
+        for (size_t sector = 0; sector < sectorCount(); ++sector)
+            eraseSector(sector);
+
+        return HAL_OK;
+    }
+
+    for (size_t i = 0; i < eraseInit.NbSectors; ++i)
+    {
+        const size_t sector = eraseInit.Sector + i;
+
+        if (sector >= sectorCount())
+        {
+            m_error = HAL_FLASH_ERROR_OPERATION;
+            *sectorError = sector;
+
+            return HAL_ERROR;
+        }
+
+        eraseSector(sector);
+    }
+
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Flash::instance() -> Flash*
+{
+    return g_instance;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Flash::eraseSector(size_t sector)
+{
+    const auto& sizes = m_settings.sectorSizes;
+
+    const size_t offset = std::accumulate(sizes.begin(), sizes.begin() + sector, size_t(0));
+    const size_t size = sizes.at(sector);
+
+    std::fill_n(m_memory + offset, size, ErasedValue);
+
+    wait(m_settings.eraseTimePerKiB * (size / 1024));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Flash::throwSystemError(const std::string& error) const
+{
+    throw std::runtime_error(error + ": " + std::strerror(errno));
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,295 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "simulation.h"
+
+#include <thread>
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace Simulation;
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    const Clock::time_point g_startTime = Clock::now();
+
+    // Shorter waits are spun rather than slept, as sleeping isn't accurate enough for them
+    constexpr auto MinimumSleepTime = std::chrono::milliseconds(1);
+
+    constexpr uint32_t CrcPolynomial = 0x04c11db7;
+    constexpr uint32_t CrcInitialValue = 0xffffffff;
+
+    uint32_t g_crcValue = CrcInitialValue;
+
+    bool g_interruptsEnabled = true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+GPIO_TypeDef g_gpioA = {};
+CRC_TypeDef g_crc = {};
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Simulation::wait(Duration duration)
+{
+    const auto end = Clock::now() + duration;
+
+    while (true)
+    {
+        if (Uart* uart = Uart::instance())
+            uart->update();
+
+        const auto remaining = end - Clock::now();
+
+        if (remaining <= Duration::zero())
+            break;
+
+        if (remaining >= MinimumSleepTime)
+            std::this_thread::sleep_for(std::min<Duration>(remaining, MinimumSleepTime));
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Simulation::interruptsEnabled() -> bool
+{
+    return g_interruptsEnabled;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_Delay(uint32_t delay)
+{
+    wait(std::chrono::milliseconds(delay));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+uint32_t HAL_GetTick()
+{
+    const auto elapsed = Clock::now() - g_startTime;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_NVIC_SystemReset()
+{
+    throw SystemReset();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void __set_MSP(uint32_t)
+{
+    throw FirmwareLaunch();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void __disable_irq()
+{
+    g_interruptsEnabled = false;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void __enable_irq()
+{
+    g_interruptsEnabled = true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void __WFI()
+{
+    wait(Duration::zero());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state)
+{
+    if (state == GPIO_PIN_SET)
+        port->ODR |= pin;
+    else
+        port->ODR &= ~uint32_t(pin);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef* port, uint16_t pin)
+{
+    port->ODR ^= pin;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+CRC_DataRegister::operator uint32_t() const
+{
+    return g_crcValue;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto CRC_DataRegister::operator=(uint32_t data) -> CRC_DataRegister&
+{
+    g_crcValue ^= data;
+
+    for (int bit = 0; bit < 32; ++bit)
+    {
+        const bool carry = g_crcValue & 0x80000000;
+        g_crcValue = carry ? (g_crcValue << 1) ^ CrcPolynomial : g_crcValue << 1;
+    }
+
+    return *this;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto CRC_ControlRegister::operator=(uint32_t control) -> CRC_ControlRegister&
+{
+    if (control & CRC_CR_RESET)
+        g_crcValue = CrcInitialValue;
+
+    return *this;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+
+    for (int bit = 0; bit < 32; ++bit, value >>= 1)
+        result = (result << 1) | (value & 1);
+
+    return result;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+DMA_CounterRegister::operator uint32_t() const
+{
+    return uart ? uart->remainingReceive() : 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+HAL_StatusTypeDef HAL_UART_RegisterCallback(UART_HandleTypeDef* huart,
+                                            HAL_UART_CallbackIDTypeDef callbackId,
+                                            pUART_CallbackTypeDef callback)
+{
+    switch (callbackId)
+    {
+    case HAL_UART_TX_COMPLETE_CB_ID:
+        huart->TxCpltCallback = callback;
+        return HAL_OK;
+
+    case HAL_UART_RX_HALFCOMPLETE_CB_ID:
+        huart->RxHalfCpltCallback = callback;
+        return HAL_OK;
+
+    case HAL_UART_RX_COMPLETE_CB_ID:
+        huart->RxCpltCallback = callback;
+        return HAL_OK;
+
+    case HAL_UART_ERROR_CB_ID:
+        huart->ErrorCallback = callback;
+        return HAL_OK;
+
+    default:
+        return HAL_ERROR;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size)
+{
+    return huart->Instance->startReceive(data, size);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data,
+                                        uint16_t size)
+{
+    return huart->Instance->transmit(data, size);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef* huart)
+{
+    return huart->Instance->abortReceive();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+HAL_StatusTypeDef HAL_FLASH_Unlock()
+{
+    return Flash::instance()->unlock();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+HAL_StatusTypeDef HAL_FLASH_Lock()
+{
+    return Flash::instance()->lock();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t typeProgram, uint32_t address, uint64_t data)
+{
+    return Flash::instance()->program(typeProgram, address, data);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+uint32_t HAL_FLASH_GetError()
+{
+    return Flash::instance()->error();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef* eraseInit, uint32_t* sectorError)
+{
+    return Flash::instance()->erase(*eraseInit, sectorError);
+}
+
+// ---------------------------------------------------------------------------------------------- //
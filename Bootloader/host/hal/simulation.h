@@ -0,0 +1,228 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "stm32f4xx_hal.h"
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace Simulation {
+
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::nanoseconds;
+
+    // Thrown by HAL_NVIC_SystemReset(). Deliberately not derived from std::exception, so that
+    // it passes through the bootloader's error handling just like a real reset would.
+    class SystemReset {};
+
+    // Thrown by __set_MSP() when the boot manager is about to jump to the firmware
+    class FirmwareLaunch {};
+
+    // Waits for the given time while keeping emulated peripherals running
+    void wait(Duration duration);
+
+    // False between __disable_irq() and __enable_irq(), emulated interrupts are held back then
+    auto interruptsEnabled() -> bool;
+
+    // ------------------------------------------------------------------------------------------ //
+
+    // Emulates NOR flash memory mapped at its physical address, so that code reading the
+    // flash through plain pointers works unmodified. Erasing sets all bits of a sector,
+    // programming can only clear bits.
+    class Flash
+    {
+    public:
+        struct Settings
+        {
+            uint32_t baseAddress = 0x08000000;
+            std::vector<uint32_t> sectorSizes;
+
+            Duration eraseTimePerKiB = {};
+            Duration programTime = {}; // Per program operation
+
+            std::string backingFile; // Flash contents are lost on exit if empty
+        };
+
+    public:
+        Flash(const Settings& settings);
+        ~Flash();
+
+        Flash(const Flash&) = delete;
+        auto operator=(const Flash&) = delete;
+
+        auto size() const -> size_t { return m_size; }
+        auto sectorCount() const -> size_t { return m_settings.sectorSizes.size(); }
+
+        void reset();
+
+        auto unlock() -> HAL_StatusTypeDef;
+        auto lock() -> HAL_StatusTypeDef;
+
+        auto program(uint32_t typeProgram, uint32_t address, uint64_t data) -> HAL_StatusTypeDef;
+        auto erase(const FLASH_EraseInitTypeDef& eraseInit,
+                   uint32_t* sectorError) -> HAL_StatusTypeDef;
+
+        auto error() const -> uint32_t { return m_error; }
+
+        static auto instance() -> Flash*;
+
+    private:
+        void eraseSector(size_t sector);
+
+        [[noreturn]] void throwSystemError(const std::string& error) const;
+
+    private:
+        Settings m_settings;
+        size_t m_size = 0;
+
+        int m_file = -1;
+        uint8_t* m_memory = nullptr; // Writable view, the readable one is at baseAddress
+
+        bool m_locked = true;
+        uint32_t m_error = HAL_FLASH_ERROR_NONE;
+    };
+
+    // ------------------------------------------------------------------------------------------ //
+
+    // Emulates a UART with DMA transfers, connected to the master side of a pseudo-terminal.
+    // The host application communicates with the device through the slave side. Alternatively,
+    // data can be exchanged in memory, which is used to benchmark the receive path.
+    class Uart
+    {
+    public:
+        enum class Transport
+        {
+            PseudoTerminal,
+            Memory
+        };
+
+        struct Settings
+        {
+            size_t baudrate = 115200; // Transfers are limited to this rate unless zero
+            Duration latency = {};    // Delay before each transmission starts, e.g. USB polling
+            Transport transport = Transport::PseudoTerminal;
+        };
+
+    public:
+        Uart(const Settings& settings);
+        ~Uart();
+
+        Uart(const Uart&) = delete;
+        auto operator=(const Uart&) = delete;
+
+        // Name of the slave device relative to /dev, e.g. "pts/3"
+        auto portName() const -> std::string { return m_portName; }
+
+        void attach(UART_HandleTypeDef* handle);
+        void reset();
+
+        auto startReceive(uint8_t* data, size_t size) -> HAL_StatusTypeDef;
+        auto abortReceive() -> HAL_StatusTypeDef;
+        auto remainingReceive() -> uint32_t;
+
+        auto transmit(const uint8_t* data, size_t size) -> HAL_StatusTypeDef;
+
+        // Aborts reception like an overrun, framing or noise error during a DMA transfer does,
+        // raising the error callback on the next update
+        void raiseError(uint32_t errorCode);
+
+        // Advances pending transfers, called whenever the emulated device observes the UART
+        void update();
+
+        // Host side of the memory transport
+        void write(const uint8_t* data, size_t size);
+        auto takeOutput() -> std::string;
+
+        static auto instance() -> Uart*;
+
+    private:
+        struct PendingByte
+        {
+            Clock::time_point time;
+            uint8_t value;
+        };
+
+        void openPseudoTerminal();
+
+        void readInput(Clock::time_point now);
+        void writeOutput(Clock::time_point now);
+        void completeReceive();
+        void completeTransmit();
+        void waitWhileIdle();
+
+        auto scheduleByte(Clock::time_point& wireTime, Clock::time_point now) const
+            -> Clock::time_point;
+
+        [[noreturn]] void throwSystemError(const std::string& error) const;
+
+    private:
+        Settings m_settings;
+        Duration m_byteTime = {};
+
+        int m_master = -1;
+        int m_slave = -1;
+        std::string m_portName;
+
+        std::string m_output; // Transmitted data not yet taken by the host, memory transport only
+
+        UART_HandleTypeDef* m_handle = nullptr;
+
+        DMA_Stream_TypeDef m_rxStream = {};
+        DMA_HandleTypeDef m_rxDma = {};
+
+        uint8_t* m_rxData = nullptr;
+        size_t m_rxSize = 0;
+        size_t m_rxCount = 0;
+        bool m_rxActive = false;
+
+        // Half and full transfer events not yet raised, these alternate in circular mode
+        size_t m_rxEventCount = 0;
+        bool m_rxHalfEventNext = true;
+
+        uint32_t m_rxError = HAL_UART_ERROR_NONE;
+
+        std::deque<PendingByte> m_rxPending;
+        std::deque<PendingByte> m_txPending;
+        bool m_txActive = false;
+
+        Clock::time_point m_rxWireTime;
+        Clock::time_point m_txWireTime;
+
+        size_t m_idleCount = 0;
+        size_t m_lastRxCount = 0;
+    };
+}
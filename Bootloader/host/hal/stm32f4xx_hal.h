@@ -0,0 +1,234 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+// Minimal stand-in for the STM32F4 HAL, providing just enough of its interface to run the
+// bootloader on a host system. Peripherals are emulated by the classes in simulation.h.
+
+#include <cstddef>
+#include <cstdint>
+
+#define STM32F4
+
+// ---------------------------------------------------------------------------------------------- //
+
+typedef enum
+{
+    HAL_OK      = 0x00,
+    HAL_ERROR   = 0x01,
+    HAL_BUSY    = 0x02,
+    HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+void HAL_Delay(uint32_t delay);
+uint32_t HAL_GetTick();
+
+void HAL_NVIC_SystemReset();
+
+// Throws Simulation::FirmwareLaunch, as the bootloader jumps to the firmware immediately after
+void __set_MSP(uint32_t topOfMainStack);
+
+// Emulated interrupts are raised from within HAL calls, unless they are disabled
+void __disable_irq();
+void __enable_irq();
+
+// Advances emulated peripherals, which may raise the interrupt being waited for
+void __WFI();
+
+// ---------------------------------------------------------------------------------------------- //
+
+struct GPIO_TypeDef
+{
+    uint32_t ODR;
+};
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+extern GPIO_TypeDef g_gpioA;
+
+#define GPIOA (&g_gpioA)
+#define GPIO_PIN_5 ((uint16_t)0x0020)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+void HAL_GPIO_TogglePin(GPIO_TypeDef* port, uint16_t pin);
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Writing the data register feeds a word to the emulated CRC unit, reading it returns the result
+class CRC_DataRegister
+{
+public:
+    operator uint32_t() const;
+    auto operator=(uint32_t data) -> CRC_DataRegister&;
+};
+
+// Writing CRC_CR_RESET reloads the initial value of 0xffffffff
+class CRC_ControlRegister
+{
+public:
+    auto operator=(uint32_t control) -> CRC_ControlRegister&;
+};
+
+struct CRC_TypeDef
+{
+    CRC_DataRegister DR;
+    uint32_t IDR;
+    CRC_ControlRegister CR;
+};
+
+extern CRC_TypeDef g_crc;
+
+#define CRC (&g_crc)
+#define CRC_CR_RESET 0x00000001U
+
+#define __HAL_RCC_CRC_CLK_ENABLE() ((void)0)
+
+uint32_t __RBIT(uint32_t value);
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace Simulation { class Uart; }
+
+// Reading the transfer counter advances the emulated transfer, much like a running DMA would
+class DMA_CounterRegister
+{
+public:
+    operator uint32_t() const;
+
+    Simulation::Uart* uart = nullptr;
+};
+
+struct DMA_Stream_TypeDef
+{
+    DMA_CounterRegister NDTR;
+};
+
+#define DMA_NORMAL   0x00000000U
+#define DMA_CIRCULAR 0x00000100U
+
+struct DMA_InitTypeDef
+{
+    uint32_t Mode;
+};
+
+struct DMA_HandleTypeDef
+{
+    DMA_Stream_TypeDef* Instance;
+    DMA_InitTypeDef Init;
+};
+
+struct UART_HandleTypeDef;
+
+typedef void (*pUART_CallbackTypeDef)(UART_HandleTypeDef* huart);
+
+typedef enum
+{
+    HAL_UART_TX_COMPLETE_CB_ID     = 0x01U,
+    HAL_UART_RX_HALFCOMPLETE_CB_ID = 0x02U,
+    HAL_UART_RX_COMPLETE_CB_ID     = 0x03U,
+    HAL_UART_ERROR_CB_ID           = 0x04U
+} HAL_UART_CallbackIDTypeDef;
+
+#define HAL_UART_ERROR_NONE 0x00000000U
+#define HAL_UART_ERROR_NE   0x00000002U
+#define HAL_UART_ERROR_FE   0x00000004U
+#define HAL_UART_ERROR_ORE  0x00000008U
+
+struct UART_HandleTypeDef
+{
+    Simulation::Uart* Instance;
+    DMA_HandleTypeDef* hdmarx;
+    DMA_HandleTypeDef* hdmatx;
+
+    uint32_t ErrorCode;
+
+    pUART_CallbackTypeDef TxCpltCallback;
+    pUART_CallbackTypeDef RxHalfCpltCallback;
+    pUART_CallbackTypeDef RxCpltCallback;
+    pUART_CallbackTypeDef ErrorCallback;
+};
+
+HAL_StatusTypeDef HAL_UART_RegisterCallback(UART_HandleTypeDef* huart,
+                                            HAL_UART_CallbackIDTypeDef callbackId,
+                                            pUART_CallbackTypeDef callback);
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size);
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data,
+                                        uint16_t size);
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef* huart);
+
+// ---------------------------------------------------------------------------------------------- //
+
+#define FLASH_TYPEERASE_SECTORS     0x00000000U
+#define FLASH_TYPEERASE_MASSERASE   0x00000001U
+
+#define FLASH_VOLTAGE_RANGE_1       0x00000000U
+#define FLASH_VOLTAGE_RANGE_2       0x00000001U
+#define FLASH_VOLTAGE_RANGE_3       0x00000002U
+#define FLASH_VOLTAGE_RANGE_4       0x00000003U
+
+#define FLASH_TYPEPROGRAM_BYTE       0x00000000U
+#define FLASH_TYPEPROGRAM_HALFWORD   0x00000001U
+#define FLASH_TYPEPROGRAM_WORD       0x00000002U
+#define FLASH_TYPEPROGRAM_DOUBLEWORD 0x00000003U
+
+#define HAL_FLASH_ERROR_NONE        0x00000000U
+#define HAL_FLASH_ERROR_PGS         0x00000002U
+#define HAL_FLASH_ERROR_PGP         0x00000004U
+#define HAL_FLASH_ERROR_PGA         0x00000008U
+#define HAL_FLASH_ERROR_WRP         0x00000010U
+#define HAL_FLASH_ERROR_OPERATION   0x00000020U
+
+struct FLASH_EraseInitTypeDef
+{
+    uint32_t TypeErase;
+    uint32_t Banks;
+    uint32_t Sector;
+    uint32_t NbSectors;
+    uint32_t VoltageRange;
+};
+
+HAL_StatusTypeDef HAL_FLASH_Unlock();
+HAL_StatusTypeDef HAL_FLASH_Lock();
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t typeProgram, uint32_t address, uint64_t data);
+uint32_t HAL_FLASH_GetError();
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef* eraseInit, uint32_t* sectorError);
@@ -0,0 +1,417 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "simulation.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace Simulation;
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    Uart* g_instance = nullptr;
+
+    constexpr size_t BitsPerByte = 10; // Start bit, eight data bits, stop bit
+
+    // Polling is only slowed down after this many consecutive updates without any activity
+    constexpr size_t IdleUpdateCount = 1000;
+    constexpr int IdleTimeoutMs = 1;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+Uart::Uart(const Settings& settings)
+    : m_settings(settings)
+{
+    if (g_instance)
+        throw std::logic_error("Only a single UART instance is supported.");
+
+    if (m_settings.baudrate > 0)
+        m_byteTime = Duration(std::chrono::seconds(BitsPerByte)) / m_settings.baudrate;
+
+    if (m_settings.transport == Transport::PseudoTerminal)
+        openPseudoTerminal();
+
+    m_rxStream.NDTR.uart = this;
+    m_rxDma.Instance = &m_rxStream;
+
+    g_instance = this;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+Uart::~Uart()
+{
+    if (m_master >= 0)
+    {
+        close(m_slave);
+        close(m_master);
+    }
+
+    g_instance = nullptr;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::attach(UART_HandleTypeDef* handle)
+{
+    handle->Instance = this;
+    handle->hdmarx = &m_rxDma;
+    handle->hdmatx = nullptr;
+
+    m_handle = handle;
+
+    // As configured for the examples, the transfer counter reloads once the buffer is full
+    m_rxDma.Init.Mode = DMA_CIRCULAR;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::reset()
+{
+    abortReceive();
+    m_txPending.clear(); // Transfers in progress are cut off by a reset
+    m_txActive = false;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Uart::startReceive(uint8_t* data, size_t size) -> HAL_StatusTypeDef
+{
+    if (m_rxActive)
+        return HAL_BUSY;
+
+    m_rxData = data;
+    m_rxSize = size;
+    m_rxCount = 0;
+    m_rxActive = true;
+
+    m_rxEventCount = 0;
+    m_rxHalfEventNext = true;
+
+    m_lastRxCount = 0;
+
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Uart::abortReceive() -> HAL_StatusTypeDef
+{
+    m_rxActive = false;
+    m_rxEventCount = 0;
+
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Uart::remainingReceive() -> uint32_t
+{
+    update();
+    waitWhileIdle();
+
+    return m_rxSize - m_rxCount;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Uart::transmit(const uint8_t* data, size_t size) -> HAL_StatusTypeDef
+{
+    // Not calling update() here, the completion callback mustn't be raised from within
+    const auto now = Clock::now();
+
+    readInput(now);
+    writeOutput(now);
+
+    if (m_txActive)
+        return HAL_BUSY;
+
+    const auto start = now + m_settings.latency;
+
+    for (size_t i = 0; i < size; ++i)
+        m_txPending.push_back({ scheduleByte(m_txWireTime, start), data[i] });
+
+    m_txActive = true;
+
+    writeOutput(now);
+
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::raiseError(uint32_t errorCode)
+{
+    m_rxActive = false;
+    m_rxEventCount = 0;
+
+    m_rxError |= errorCode;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::update()
+{
+    const auto now = Clock::now();
+
+    readInput(now);
+    writeOutput(now);
+
+    completeReceive();
+    completeTransmit();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::write(const uint8_t* data, size_t size)
+{
+    const auto now = Clock::now();
+
+    for (size_t i = 0; i < size; ++i)
+        m_rxPending.push_back({ scheduleByte(m_rxWireTime, now), data[i] });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Uart::takeOutput() -> std::string
+{
+    update();
+    return std::exchange(m_output, {});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Uart::instance() -> Uart*
+{
+    return g_instance;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::openPseudoTerminal()
+{
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (m_master < 0)
+        throwSystemError("Unable to open pseudo-terminal");
+
+    if (grantpt(m_master) < 0 || unlockpt(m_master) < 0)
+        throwSystemError("Unable to unlock pseudo-terminal");
+
+    const char* name = ptsname(m_master);
+
+    if (!name)
+        throwSystemError("Unable to get name of pseudo-terminal");
+
+    m_portName = name;
+
+    if (m_portName.starts_with("/dev/"))
+        m_portName.erase(0, 5);
+
+    // Keep the slave side open, otherwise the master reports hang-ups whenever the host closes it
+    m_slave = open(name, O_RDWR | O_NOCTTY);
+
+    if (m_slave < 0)
+        throwSystemError("Unable to open pseudo-terminal");
+
+    termios tty = {};
+    tcgetattr(m_slave, &tty);
+    cfmakeraw(&tty);
+    tcsetattr(m_slave, TCSANOW, &tty);
+
+    fcntl(m_master, F_SETFL, fcntl(m_master, F_GETFL) | O_NONBLOCK);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::readInput(Clock::time_point now)
+{
+    std::array<uint8_t, 256> buffer;
+    ssize_t count = 0;
+
+    while (m_master >= 0 && (count = read(m_master, buffer.data(), buffer.size())) > 0)
+    {
+        for (ssize_t i = 0; i < count; ++i)
+            m_rxPending.push_back({ scheduleByte(m_rxWireTime, now), buffer[i] });
+    }
+
+    while (!m_rxPending.empty() && m_rxPending.front().time <= now)
+    {
+        const uint8_t value = m_rxPending.front().value;
+        m_rxPending.pop_front();
+
+        // Bytes are lost if no transfer is active (overrun)
+        if (!m_rxActive || m_rxCount == m_rxSize)
+            continue;
+
+        m_rxData[m_rxCount++] = value;
+
+        if (m_rxCount == m_rxSize / 2 || m_rxCount == m_rxSize)
+            ++m_rxEventCount;
+
+        // A circular transfer continues at the start of the buffer
+        if (m_rxCount == m_rxSize && m_rxDma.Init.Mode == DMA_CIRCULAR)
+            m_rxCount = 0;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::writeOutput(Clock::time_point now)
+{
+    std::array<uint8_t, 256> buffer;
+    size_t count = 0;
+
+    for (auto it = m_txPending.begin(); it != m_txPending.end() && it->time <= now; ++it)
+    {
+        if (count == buffer.size())
+            break;
+
+        buffer[count++] = it->value;
+    }
+
+    if (count == 0)
+        return;
+
+    if (m_master < 0)
+    {
+        m_output.append(buffer.begin(), buffer.begin() + count);
+        m_txPending.erase(m_txPending.begin(), m_txPending.begin() + count);
+        return;
+    }
+
+    const ssize_t written = ::write(m_master, buffer.data(), count);
+
+    if (written > 0)
+        m_txPending.erase(m_txPending.begin(), m_txPending.begin() + written);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::completeReceive()
+{
+    if (!interruptsEnabled() || !m_handle)
+        return;
+
+    while (m_rxEventCount > 0)
+    {
+        --m_rxEventCount;
+
+        const auto callback = m_rxHalfEventNext ? m_handle->RxHalfCpltCallback
+                                                : m_handle->RxCpltCallback;
+        m_rxHalfEventNext = !m_rxHalfEventNext;
+
+        if (callback)
+            callback(m_handle);
+    }
+
+    if (m_rxError != HAL_UART_ERROR_NONE)
+    {
+        m_handle->ErrorCode = std::exchange(m_rxError, HAL_UART_ERROR_NONE);
+
+        // May restart reception right away
+        if (m_handle->ErrorCallback)
+            m_handle->ErrorCallback(m_handle);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::completeTransmit()
+{
+    if (!m_txActive || !m_txPending.empty() || !interruptsEnabled())
+        return;
+
+    m_txActive = false;
+
+    // May start the next transfer right away
+    if (m_handle && m_handle->TxCpltCallback)
+        m_handle->TxCpltCallback(m_handle);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::waitWhileIdle()
+{
+    const bool idle = (m_rxCount == m_lastRxCount) && m_rxPending.empty() && m_txPending.empty();
+
+    m_lastRxCount = m_rxCount;
+
+    if (!idle || m_master < 0)
+    {
+        m_idleCount = 0;
+        return;
+    }
+
+    // Avoid burning CPU time while waiting for the host, without adding noticeable latency
+    if (++m_idleCount >= IdleUpdateCount)
+    {
+        pollfd fd = { m_master, POLLIN, 0 };
+        poll(&fd, 1, IdleTimeoutMs);
+
+        m_idleCount = 0;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Uart::scheduleByte(Clock::time_point& wireTime, Clock::time_point now) const
+    -> Clock::time_point
+{
+    // Bytes are transferred back-to-back, but never before they are available
+    wireTime = std::max(wireTime, now) + m_byteTime;
+    return wireTime;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Uart::throwSystemError(const std::string& error) const
+{
+    throw std::runtime_error(error + ": " + std::strerror(errno));
+}
+
+// ---------------------------------------------------------------------------------------------- //
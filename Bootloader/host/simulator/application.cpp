@@ -0,0 +1 @@
+../../examples/Nucleo-F446RE-Bootloader/User/application.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../../examples/Nucleo-F446RE-Bootloader/User/application.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../bootloader/bootloader.cpp
\ No newline at end of file
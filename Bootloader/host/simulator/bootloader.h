@@ -0,0 +1 @@
+../../bootloader/bootloader.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../bootloader/bootmanager.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../../bootloader/bootmanager.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../bootloader/checksum.cpp
\ No newline at end of file
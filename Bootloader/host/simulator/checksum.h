@@ -0,0 +1 @@
+../../bootloader/checksum.h
\ No newline at end of file
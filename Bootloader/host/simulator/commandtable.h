@@ -0,0 +1 @@
+../../examples/Common/commandtable.h
\ No newline at end of file
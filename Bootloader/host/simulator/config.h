@@ -0,0 +1,132 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "crcengine.h"
+#include "main.h"
+
+#include <iterator>
+
+extern UART_HandleTypeDef huart2;
+
+// The flash layout can be overridden when configuring the build
+#ifndef SIMULATOR_SECTOR_SIZES
+#define SIMULATOR_SECTOR_SIZES 16, 16, 16, 16, 64, 128, 128, 128 // KiB, as on the STM32F446RE
+#endif
+
+#ifndef SIMULATOR_FIRMWARE_START_SECTOR
+#define SIMULATOR_FIRMWARE_START_SECTOR 2
+#endif
+
+#ifndef SIMULATOR_FIRMWARE_SECTOR_COUNT
+#define SIMULATOR_FIRMWARE_SECTOR_COUNT 6
+#endif
+
+#ifndef SIMULATOR_STAGING_START_SECTOR
+#define SIMULATOR_STAGING_START_SECTOR 0
+#endif
+
+#ifndef SIMULATOR_STAGING_SECTOR_COUNT
+#define SIMULATOR_STAGING_SECTOR_COUNT 0 // Staging disabled
+#endif
+
+#ifndef SIMULATOR_SCRATCH_SECTOR
+#define SIMULATOR_SCRATCH_SECTOR 0 // Patching disabled
+#endif
+
+#ifndef SIMULATOR_CRC_ENGINE
+#define SIMULATOR_CRC_ENGINE Hardware
+#endif
+
+#ifndef SIMULATOR_FRAME_SIZE
+#define SIMULATOR_FRAME_SIZE 80
+#endif
+
+namespace Config {
+    constexpr const char* BoardName = "NucleoF446RE";
+    constexpr const char* HardwareVersion = "1.0";
+    constexpr const char* BootloaderVersion = "1.0";
+
+    constexpr uint32_t RamStartAddress = 0x20000004;
+    constexpr uint32_t RamEndAddress   = 0x20020000;
+
+    constexpr uint32_t FlashBaseAddress = 0x08000000;
+    constexpr uint32_t FlashSectorSizes[] = { SIMULATOR_SECTOR_SIZES };
+
+    constexpr uint32_t FlashSectorCount = std::size(FlashSectorSizes);
+
+    constexpr auto sectorAddress(uint32_t sector) -> uint32_t
+    {
+        uint32_t address = FlashBaseAddress;
+
+        for (uint32_t i = 0; i < sector; ++i)
+            address += FlashSectorSizes[i] * 1024;
+
+        return address;
+    }
+
+    constexpr uint32_t FirmwareStartSector = SIMULATOR_FIRMWARE_START_SECTOR;
+    constexpr uint32_t FirmwareSectorCount = SIMULATOR_FIRMWARE_SECTOR_COUNT;
+
+    static_assert(FirmwareStartSector + FirmwareSectorCount <= FlashSectorCount,
+                  "Firmware sectors exceed flash memory.");
+
+    constexpr uint32_t FirmwareStartAddress = sectorAddress(FirmwareStartSector);
+    constexpr uint32_t FirmwareEndAddress   = sectorAddress(FirmwareStartSector +
+                                                            FirmwareSectorCount) - 2 * sizeof(uint32_t);
+
+    constexpr uint32_t ChecksumAddress = FirmwareEndAddress;
+
+    constexpr uint32_t StagingStartSector = SIMULATOR_STAGING_START_SECTOR;
+    constexpr uint32_t StagingSectorCount = SIMULATOR_STAGING_SECTOR_COUNT;
+
+    static_assert(StagingStartSector + StagingSectorCount <= FlashSectorCount,
+                  "Staging sectors exceed flash memory.");
+
+    constexpr uint32_t StagingStartAddress = sectorAddress(StagingStartSector);
+    constexpr uint32_t StagingEndAddress   = sectorAddress(StagingStartSector + StagingSectorCount)
+                                             - 2 * sizeof(uint32_t);
+
+    constexpr uint32_t ScratchSector = SIMULATOR_SCRATCH_SECTOR;
+
+    static_assert(ScratchSector < FlashSectorCount, "Scratch sector exceeds flash memory.");
+
+    constexpr uint32_t ScratchAddress = (ScratchSector != 0) ? sectorAddress(ScratchSector) : 0;
+
+    constexpr CrcEngine ChecksumEngine = CrcEngine::SIMULATOR_CRC_ENGINE;
+
+    constexpr UART_HandleTypeDef* HostInterfaceHandle = &huart2;
+
+    constexpr size_t MaximumFrameSize = SIMULATOR_FRAME_SIZE;
+}
@@ -0,0 +1 @@
+../../bootloader/crc32.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../bootloader/crc32.h
\ No newline at end of file
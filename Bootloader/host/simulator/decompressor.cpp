@@ -0,0 +1 @@
+../../bootloader/decompressor.cpp
\ No newline at end of file
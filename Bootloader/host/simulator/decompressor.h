@@ -0,0 +1 @@
+../../bootloader/decompressor.h
\ No newline at end of file
@@ -0,0 +1,220 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "bootmanager.h"
+#include "firmwarestub.h"
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr char TokenSeparator = ' ';
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+FirmwareStub::FirmwareStub(const char* firmwareVersion)
+    : m_firmwareVersion(firmwareVersion),
+      m_stager(this),
+      m_hostInterface(this) {}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::exec()
+{
+    while (true)
+        m_hostInterface.update();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::onHostDataReceived(const String& data)
+{
+    const String tag = data.getToken(TokenSeparator, 0);
+
+    if (tag == "<GET_BOOT_MODE>")
+        sendResponse("<BOOT_MODE> FIRMWARE");
+    else if (tag == "<GET_BOARD_NAME>")
+        sendResponse("<BOARD_NAME>", Config::BoardName);
+    else if (tag == "<GET_HARDWARE_VERSION>")
+        sendResponse("<HARDWARE_VERSION>", Config::HardwareVersion);
+    else if (tag == "<GET_FIRMWARE_VERSION>")
+        sendResponse("<FIRMWARE_VERSION>", m_firmwareVersion);
+    else if (tag == "<GET_SECTOR_COUNT>")
+        sendResponse("<SECTOR_COUNT>", String::makeFormat("%lu", m_stager.info().sectorCount));
+    else if (tag == "<GET_FRAME_SIZE>")
+        sendResponse("<FRAME_SIZE>", String::makeFormat("%lu", Config::MaximumFrameSize));
+    else if (tag == "<GET_STAGED_FIRMWARE_VALID>")
+        sendResponse("<STAGED_FIRMWARE_VALID>", m_stager.getImageValid() ? "1" : "0");
+    else if (tag == "<LAUNCH_BOOTLOADER>")
+        protocolLaunchBootloader();
+    else if (tag == "<INSTALL_FIRMWARE>")
+        protocolInstallFirmware();
+    else if (tag == "<UNLOCK_FIRMWARE>")
+        protocolUnlockFirmware();
+    else if (tag == "<LOCK_FIRMWARE>")
+        protocolLockFirmware();
+    else if (tag == "<ERASE_SECTOR>" || tag == "<ERASE_RANGE>")
+        protocolEraseSectors(data);
+    else if (tag == "<WRITE_HEX_RECORD>")
+        protocolWriteHexRecord(data);
+    else
+        sendError("UNKNOWN_COMMAND");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::onHostDataOverflow()
+{
+    sendError("DATA_OVERFLOW");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::onSectorErase(size_t sector)
+{
+    sendResponse("<ERASING>", String::makeFormat("%u", static_cast<unsigned>(sector)));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::protocolLaunchBootloader()
+{
+    sendResponse("<OK>");
+
+    m_hostInterface.callWhenSent([] { BootManager::reboot(BootManager::Mode::Bootloader); });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// The boot manager installs the staged image before launching it
+void FirmwareStub::protocolInstallFirmware()
+{
+    if (!m_stager.getImageValid())
+        return sendError("STAGED_FIRMWARE_INVALID");
+
+    m_stager.lock();
+    sendResponse("<OK>");
+
+    m_hostInterface.callWhenSent([] { BootManager::reboot(BootManager::Mode::Firmware); });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::protocolUnlockFirmware()
+{
+    try {
+        m_stager.unlock();
+        m_sequencer.reset();
+
+        sendResponse("<OK>");
+    }
+    catch (const std::exception& e) {
+        sendError(e.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::protocolLockFirmware()
+{
+    m_stager.lock();
+    sendResponse("<OK>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::protocolEraseSectors(const String& data)
+{
+    const bool range = (data.getToken(TokenSeparator, 0) == "<ERASE_RANGE>");
+
+    if (data.getTokenCount(TokenSeparator) != (range ? 3 : 2))
+        return sendError("MISSING_PARAMETER");
+
+    try {
+        const auto first = data.getToken(TokenSeparator, 1).toULong();
+
+        if (range)
+            m_stager.eraseSectors(first, data.getToken(TokenSeparator, 2).toULong());
+        else
+            m_stager.eraseSector(first);
+
+        sendResponse("<OK>");
+    }
+    catch (const std::exception& e) {
+        sendError(e.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::protocolWriteHexRecord(const String& data)
+{
+    const size_t tokenCount = data.getTokenCount(TokenSeparator);
+
+    if (tokenCount < 2)
+        return sendError("MISSING_PARAMETER");
+
+    const String record = data.getToken(TokenSeparator, 1);
+    const String sequence = (tokenCount > 2) ? data.getToken(TokenSeparator, 2) : String();
+
+    try {
+        m_sequencer.write({ record.data(), record.size() }, { sequence.data(), sequence.size() },
+                          [this](std::span<const char> line) { m_stager.writeHexRecord(line); });
+
+        sendResponse("<OK>", sequence);
+    }
+    catch (const std::exception& e) {
+        sendError(e.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::sendResponse(const String& tag, const String& data)
+{
+    auto response = tag;
+
+    if (!data.empty())
+        response += " " + data;
+
+    m_hostInterface.sendData(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareStub::sendError(const String& error)
+{
+    m_hostInterface.sendData("<ERROR> " + error);
+}
+
+// ---------------------------------------------------------------------------------------------- //
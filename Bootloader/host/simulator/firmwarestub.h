@@ -0,0 +1,73 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "hostinterface.h"
+#include "stager.h"
+#include "writesequencer.h"
+
+// Stands in for the firmware once the boot manager launches it. Implements the same protocol
+// as the firmware example, which is sufficient for switching back to the bootloader and for
+// staging updates while the firmware is running.
+
+class FirmwareStub : public HostInterface::Owner, public Stager::Owner
+{
+public:
+    FirmwareStub(const char* firmwareVersion);
+
+    void exec();
+
+private:
+    void onHostDataReceived(const String& data) override;
+    void onHostDataOverflow() override;
+
+    void onSectorErase(size_t sector) override;
+
+    void protocolLaunchBootloader();
+    void protocolInstallFirmware();
+
+    void protocolUnlockFirmware();
+    void protocolLockFirmware();
+    void protocolEraseSectors(const String& data);
+    void protocolWriteHexRecord(const String& data);
+
+    void sendResponse(const String& tag, const String& data = {});
+    void sendError(const String& error);
+
+private:
+    const char* m_firmwareVersion;
+    Stager m_stager;
+    HostInterface m_hostInterface;
+    WriteSequencer m_sequencer;
+};
@@ -0,0 +1 @@
+../../bootloader/hexrecord.cpp
\ No newline at end of file
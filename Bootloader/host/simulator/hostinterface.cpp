@@ -0,0 +1 @@
+../../examples/Common/hostinterface.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../../examples/Common/hostinterface.h
\ No newline at end of file
@@ -0,0 +1,201 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "application.h"
+#include "bootmanager.h"
+#include "firmwarestub.h"
+#include "simulation.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <getopt.h>
+
+// ---------------------------------------------------------------------------------------------- //
+
+UART_HandleTypeDef huart2 = {};
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    struct Options
+    {
+        Simulation::Flash::Settings flash;
+        Simulation::Uart::Settings uart;
+
+        std::string firmwareVersion = "1.0";
+    };
+
+    void printUsage(const char* program)
+    {
+        std::cout <<
+            "Usage: " << program << " [options]\n"
+            "\n"
+            "Runs the bootloader on the host, connected to a pseudo-terminal whose name\n"
+            "relative to /dev is printed on startup.\n"
+            "\n"
+            "Options:\n"
+            "  --baudrate <rate>         Emulated baud rate, 0 for unlimited (default: 115200)\n"
+            "  --latency <us>            Delay before each response is sent (default: 0)\n"
+            "  --erase-time <us>         Erase time per KiB of flash (default: 0, typ. 8000)\n"
+            "  --program-time <us>       Time per program operation (default: 0, typ. 16)\n"
+            "  --flash-file <file>       Keep flash contents in the given file\n"
+            "  --firmware-version <ver>  Version reported by the firmware (default: 1.0)\n"
+            "  --help                    Show this help\n";
+    }
+
+    auto parseOptions(int argc, char* argv[], Options* options) -> bool
+    {
+        enum { Baudrate, Latency, EraseTime, ProgramTime, FlashFile, FirmwareVersion, Help };
+
+        static const option longOptions[] = {
+            { "baudrate",         required_argument, nullptr, Baudrate        },
+            { "latency",          required_argument, nullptr, Latency         },
+            { "erase-time",       required_argument, nullptr, EraseTime       },
+            { "program-time",     required_argument, nullptr, ProgramTime     },
+            { "flash-file",       required_argument, nullptr, FlashFile       },
+            { "firmware-version", required_argument, nullptr, FirmwareVersion },
+            { "help",             no_argument,       nullptr, Help            },
+            { nullptr,            0,                 nullptr, 0               }
+        };
+
+        int option = 0;
+
+        while ((option = getopt_long(argc, argv, "", longOptions, nullptr)) != -1)
+        {
+            switch (option)
+            {
+            case Baudrate:
+                options->uart.baudrate = std::stoul(optarg);
+                break;
+
+            case Latency:
+                options->uart.latency = std::chrono::microseconds(std::stoul(optarg));
+                break;
+
+            case EraseTime:
+                options->flash.eraseTimePerKiB = std::chrono::microseconds(std::stoul(optarg));
+                break;
+
+            case ProgramTime:
+                options->flash.programTime = std::chrono::microseconds(std::stoul(optarg));
+                break;
+
+            case FlashFile:
+                options->flash.backingFile = optarg;
+                break;
+
+            case FirmwareVersion:
+                options->firmwareVersion = optarg;
+                break;
+
+            default:
+                return false;
+            }
+        }
+
+        return optind == argc;
+    }
+
+    auto launchFirmware() -> bool
+    {
+        try {
+            boot_manager_init();
+        }
+        catch (const Simulation::FirmwareLaunch&) {
+            return true;
+        }
+
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main(int argc, char* argv[]) -> int
+{
+    Options options;
+
+    for (uint32_t size : Config::FlashSectorSizes)
+        options.flash.sectorSizes.push_back(size * 1024);
+
+    options.flash.baseAddress = Config::FlashBaseAddress;
+
+    try {
+        if (!parseOptions(argc, argv, &options))
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        Simulation::Flash flash(options.flash);
+        Simulation::Uart uart(options.uart);
+
+        uart.attach(&huart2);
+
+        std::cout << uart.portName() << std::endl;
+
+        while (true)
+        {
+            try {
+                if (launchFirmware())
+                {
+                    FirmwareStub firmware(options.firmwareVersion.c_str());
+                    firmware.exec();
+                }
+                else
+                {
+                    Application application;
+                    application.exec();
+                }
+            }
+            catch (const Simulation::SystemReset&) {
+                flash.reset();
+                uart.reset();
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
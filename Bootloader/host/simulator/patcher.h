@@ -0,0 +1 @@
+../../bootloader/patcher.h
\ No newline at end of file
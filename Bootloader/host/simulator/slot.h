@@ -0,0 +1 @@
+../../bootloader/slot.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../bootloader/stager.cpp
\ No newline at end of file
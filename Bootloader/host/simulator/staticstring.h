@@ -0,0 +1 @@
+../../examples/Common/staticstring.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../examples/Common/string.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../examples/Common/writesequencer.h
\ No newline at end of file
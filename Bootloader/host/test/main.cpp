@@ -0,0 +1,892 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2024                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+
+// Checks the bootloader's data paths on the host: the CRC engines against the reference
+// implementation, hex record parsing, decompression of streams produced by a reference LZSS
+// encoder, overflow handling of the host interface, revisiting rows in the programmer, retrying
+// an abandoned upload and delta patching of an image in the emulated flash. Returns non-zero on failure, so that it can run as
+// a test.
+
+#include "bootloader.h"
+#include "checksum.h"
+#include "crc32.h"
+#include "crcengine.h"
+#include "decompressor.h"
+#include "hexrecord.h"
+#include "hostinterface.h"
+#include "patcher.h"
+#include "programmer.h"
+#include "simulation.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------- //
+
+UART_HandleTypeDef huart2 = {};
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    using ByteArray = std::vector<uint8_t>;
+
+    size_t g_failures = 0;
+
+    void check(bool condition, const std::string& description)
+    {
+        if (condition)
+            return;
+
+        std::fprintf(stderr, "FAILED: %s\n", description.c_str());
+        ++g_failures;
+    }
+
+    // Runs the function and checks that it throws an exception of the given type
+    template <typename Exception>
+    void checkThrows(const std::function<void()>& function, const std::string& description,
+                     const std::function<bool(const Exception&)>& matches = {})
+    {
+        try {
+            function();
+        }
+        catch (const Exception& e) {
+            check(!matches || matches(e), description + " (" + e.what() + ")");
+            return;
+        }
+        catch (const std::exception& e) {
+            check(false, description + " (unexpected " + e.what() + ")");
+            return;
+        }
+
+        check(false, description + " (no error)");
+    }
+
+    auto makeRandomData(size_t size, uint32_t seed) -> ByteArray
+    {
+        std::mt19937 generator(seed);
+        ByteArray data(size);
+
+        for (uint8_t& byte : data)
+            byte = static_cast<uint8_t>(generator());
+
+        return data;
+    }
+
+    void appendLittleEndian(ByteArray* bytes, uint32_t value, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            bytes->push_back(static_cast<uint8_t>(value >> (i*8)));
+    }
+
+    auto encodeBase64(const ByteArray& bytes) -> std::string
+    {
+        static constexpr char Alphabet[] =
+                "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string string;
+
+        for (size_t i = 0; i < bytes.size(); i += 3)
+        {
+            const size_t count = std::min<size_t>(3, bytes.size() - i);
+            uint32_t word = 0;
+
+            for (size_t j = 0; j < 3; ++j)
+                word = (word << 8) | (j < count ? bytes[i + j] : 0);
+
+            for (size_t j = 0; j < 4; ++j)
+                string += (j <= count) ? Alphabet[(word >> (18 - 6 * j)) & 0x3f] : '=';
+        }
+
+        return string;
+    }
+
+    auto makeRecord(uint8_t type, uint16_t address, const ByteArray& data) -> std::string
+    {
+        static constexpr char Digits[] = "0123456789ABCDEF";
+
+        std::string record = ":";
+        uint8_t checksum = 0;
+
+        auto append = [&](uint8_t value) {
+            record += Digits[value >> 4];
+            record += Digits[value & 0x0f];
+            checksum += value;
+        };
+
+        append(static_cast<uint8_t>(data.size()));
+        append(static_cast<uint8_t>(address >> 8));
+        append(static_cast<uint8_t>(address));
+        append(type);
+
+        for (uint8_t value : data)
+            append(value);
+
+        append(static_cast<uint8_t>(-checksum));
+
+        return record;
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    // Every engine must match the reference for all lengths and alignments, as the tables and
+    // the hardware engine handle leading and trailing bytes separately
+    void testCrcEngines()
+    {
+        const ByteArray data = makeRandomData(4096, 1);
+        const uint32_t seeds[] = { 0, 0xffffffff, 0x12345678 };
+
+        for (uint32_t seed : seeds)
+        {
+            for (size_t offset = 0; offset < 8; ++offset)
+            {
+                for (size_t length = 0; length <= 1024; length += (length < 64) ? 1 : 61)
+                {
+                    const uint8_t* buffer = data.data() + offset;
+                    const uint32_t expected = crc32_update_buffer(seed, buffer, length);
+
+                    const uint32_t results[] = {
+                        Crc32::update<CrcEngine::Bytewise>(seed, buffer, length),
+                        Crc32::update<CrcEngine::Slicing4>(seed, buffer, length),
+                        Crc32::update<CrcEngine::Slicing8>(seed, buffer, length),
+                        Crc32::update<CrcEngine::Hardware>(seed, buffer, length)
+                    };
+
+                    const char* names[] = { "Bytewise", "Slicing4", "Slicing8", "Hardware" };
+
+                    for (size_t i = 0; i < std::size(results); ++i)
+                    {
+                        check(results[i] == expected,
+                              std::string("Crc32/") + names[i] + " offset " +
+                              std::to_string(offset) + " length " + std::to_string(length));
+                    }
+                }
+            }
+        }
+
+        // Checksums are computed in chunks by the programmer, so chaining must be seamless
+        const uint32_t whole = Crc32::update<Config::ChecksumEngine>(0, data.data(), data.size());
+        const uint32_t first = Crc32::update<Config::ChecksumEngine>(0, data.data(), 1001);
+        const uint32_t chained = Crc32::update<Config::ChecksumEngine>(first, data.data() + 1001,
+                                                                       data.size() - 1001);
+        check(chained == whole, "Crc32 chaining");
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    void testHexRecord()
+    {
+        using Error = HexRecord::ParserError;
+
+        const ByteArray data = { 0x00, 0x01, 0x02, 0x03, 0xfc, 0xfd, 0xfe, 0xff };
+        const std::string valid = makeRecord(0x00, 0x1234, data);
+
+        const HexRecord record = HexRecord::fromString(std::span(valid));
+
+        check(record.type() == HexRecord::Type::Data, "HexRecord type");
+        check(record.address() == 0x1234, "HexRecord address");
+        check(record.length() == data.size(), "HexRecord length");
+        check(std::equal(data.begin(), data.end(), record.data().begin()), "HexRecord data");
+        check(record.checksum() == record.computeChecksum(), "HexRecord checksum");
+
+        std::string lowerCase = valid;
+        std::transform(lowerCase.begin(), lowerCase.end(), lowerCase.begin(), ::tolower);
+
+        check(HexRecord::fromString(std::span(lowerCase)).data()[7] == 0xff,
+              "HexRecord lower case digits");
+
+        const std::string eof = ":00000001FF";
+        check(HexRecord::fromString(std::span(eof)).type() == HexRecord::Type::EndOfFile,
+              "HexRecord end of file");
+
+        auto expectError = [](const std::string& string, Error::Type type,
+                              const std::string& description) {
+            checkThrows<Error>([&] { HexRecord::fromString(std::span(string)); },
+                               "HexRecord " + description,
+                               [&](const Error& e) { return e.type() == type; });
+        };
+
+        std::string badChecksum = valid;
+        badChecksum.back() = (badChecksum.back() == '0') ? '1' : '0';
+
+        std::string badDigit = valid;
+        badDigit[12] = 'G';
+
+        expectError(badChecksum, Error::Type::InvalidChecksum, "checksum");
+        expectError(badDigit, Error::Type::InvalidRecord, "digit");
+        expectError(valid.substr(1), Error::Type::InvalidRecord, "start code");
+        expectError(valid.substr(0, valid.size() - 2), Error::Type::InvalidRecord, "truncated");
+        expectError(valid + "00", Error::Type::InvalidRecord, "trailing data");
+        expectError(makeRecord(0x06, 0, {}), Error::Type::InvalidType, "type");
+        expectError(makeRecord(0x00, 0, ByteArray(HexRecord::MaximumLength + 1)),
+                    Error::Type::InvalidLength, "length");
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    // Greedy LZSS encoder for the Decompressor's block format, filling each block up to the
+    // payload that fits into a frame. Matches reach back into preceding blocks.
+    auto compress(const ByteArray& data, uint32_t address) -> std::vector<std::string>
+    {
+        static constexpr size_t MaximumPayload = Decompressor::MaximumBlockSize
+                                                 - Decompressor::HeaderSize;
+        static constexpr size_t MinimumMatch = 3;
+        static constexpr size_t MaximumMatch = 66;
+
+        std::vector<std::string> blocks;
+        size_t position = 0;
+
+        while (position < data.size())
+        {
+            const size_t start = position;
+            ByteArray payload;
+            size_t flagIndex = 0;
+            size_t items = 0;
+
+            while (position < data.size() && position - start < Decompressor::MaximumLength)
+            {
+                const size_t limit = std::min({ MaximumMatch, data.size() - position,
+                                                Decompressor::MaximumLength - (position - start) });
+                size_t bestLength = 0;
+                size_t bestDistance = 0;
+
+                for (size_t distance = 1; distance <= std::min(position, Decompressor::WindowSize);
+                     ++distance)
+                {
+                    size_t length = 0;
+
+                    while (length < limit && data[position + length]
+                                             == data[position - distance + length])
+                        ++length;
+
+                    if (length > bestLength)
+                    {
+                        bestLength = length;
+                        bestDistance = distance;
+                    }
+                }
+
+                const bool match = (bestLength >= MinimumMatch);
+                const size_t size = (match ? 2 : 1) + ((items % 8 == 0) ? 1 : 0);
+
+                if (payload.size() + size > MaximumPayload)
+                    break;
+
+                if (items % 8 == 0)
+                {
+                    flagIndex = payload.size();
+                    payload.push_back(0);
+                }
+
+                if (match)
+                {
+                    const uint16_t value = static_cast<uint16_t>(((bestDistance - 1) << 6)
+                                                                 | (bestLength - MinimumMatch));
+                    payload.push_back(static_cast<uint8_t>(value >> 8));
+                    payload.push_back(static_cast<uint8_t>(value));
+                    position += bestLength;
+                }
+                else
+                {
+                    payload[flagIndex] |= static_cast<uint8_t>(1 << (items % 8));
+                    payload.push_back(data[position++]);
+                }
+
+                ++items;
+            }
+
+            const uint32_t blockAddress = address + start;
+            const uint32_t length = position - start;
+
+            ByteArray block;
+            appendLittleEndian(&block, blockAddress, 4);
+            appendLittleEndian(&block, length, 2);
+
+            const uint32_t crc = crc32_update_buffer(crc32_update_buffer(0, block.data(), 6),
+                                                     data.data() + start, length);
+            appendLittleEndian(&block, crc, 4);
+            block.insert(block.end(), payload.begin(), payload.end());
+
+            blocks.push_back(encodeBase64(block));
+        }
+
+        return blocks;
+    }
+
+    auto decompress(const std::vector<std::string>& blocks, uint32_t address) -> ByteArray
+    {
+        Decompressor decompressor;
+        ByteArray result;
+
+        for (const std::string& block : blocks)
+        {
+            const Decompressor::Output output = decompressor.decompress(std::span(block));
+
+            check(output.address == address + result.size(), "Decompressor block address");
+            result.insert(result.end(), output.data.begin(), output.data.end());
+        }
+
+        return result;
+    }
+
+    void testDecompressor()
+    {
+        using Error = Decompressor::Error;
+
+        // Random data is all literals, repeated tables and fills exercise long and
+        // overlapping matches as well as matches into previous blocks
+        ByteArray mixed = makeRandomData(300, 2);
+        mixed.resize(2500, 0xff);
+
+        const ByteArray table = makeRandomData(200, 3);
+
+        for (size_t i = 0; i < 5; ++i)
+            mixed.insert(mixed.end(), table.begin(), table.end());
+
+        const struct {
+            const char* name;
+            ByteArray data;
+        } inputs[] = {
+            { "random", makeRandomData(3000, 4) },
+            { "fill", ByteArray(5000, 0x00) },
+            { "mixed", mixed }
+        };
+
+        for (const auto& input : inputs)
+        {
+            const uint32_t address = Config::FirmwareStartAddress;
+            const std::vector<std::string> blocks = compress(input.data, address);
+
+            try {
+                check(decompress(blocks, address) == input.data,
+                      std::string("Decompressor round trip ") + input.name);
+            }
+            catch (const std::exception& e) {
+                check(false, std::string("Decompressor round trip ") + input.name + " ("
+                             + e.what() + ")");
+            }
+        }
+
+        const std::vector<std::string> blocks = compress(makeRandomData(100, 5), 0);
+
+        std::string corrupted = blocks.front();
+        corrupted[20] = (corrupted[20] == 'A') ? 'B' : 'A';
+
+        checkThrows<Error>([&] { Decompressor().decompress(std::span(corrupted)); },
+                           "Decompressor corrupted block");
+
+        const std::string invalid = blocks.front().substr(1);
+
+        checkThrows<Error>([&] { Decompressor().decompress(std::span(invalid)); },
+                           "Decompressor invalid Base64");
+
+        // A match reaching before the start of the stream
+        ByteArray block;
+        appendLittleEndian(&block, 0, 4);
+        appendLittleEndian(&block, 3, 2);
+        appendLittleEndian(&block, 0, 4);
+        block.insert(block.end(), { 0x00, 0x00, 0x00 });
+
+        const std::string outOfWindow = encodeBase64(block);
+
+        checkThrows<Error>([&] { Decompressor().decompress(std::span(outOfWindow)); },
+                           "Decompressor match outside window",
+                           [](const Error& e) { return e.type() == Error::Type::InvalidData; });
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    // Records requests and overflows, optionally letting the host send more data while the first
+    // request is being handled, as if the device were busy erasing
+    class RecordingOwner : public HostInterface::Owner
+    {
+    public:
+        std::vector<std::string> requests;
+        size_t overflows = 0;
+
+        std::function<void()> onFirstRequest;
+
+    private:
+        void onHostDataReceived(const String& data) override
+        {
+            requests.emplace_back(data.data(), data.size());
+
+            if (requests.size() == 1 && onFirstRequest)
+                onFirstRequest();
+        }
+
+        void onHostDataOverflow() override { ++overflows; }
+    };
+
+    void sendToDevice(Simulation::Uart& uart, const std::string& data)
+    {
+        uart.write(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    }
+
+    // Each case aborts reception first, so that a new interface can start it over
+    void testHostInterface(Simulation::Uart& uart)
+    {
+        const std::string filler(HostInterface::ReceiveBufferSize, 'x');
+
+        {
+            HAL_UART_AbortReceive(&huart2);
+
+            RecordingOwner owner;
+            HostInterface hostInterface(&owner);
+
+            // Back-to-back requests, together exceeding the buffer several times, but read in time
+            for (size_t i = 0; i < 32; ++i)
+            {
+                sendToDevice(uart, "<REQUEST> " + std::to_string(i) + "\r\n<PING>\r\n");
+                hostInterface.update();
+            }
+
+            check(owner.requests.size() == 64 && owner.requests[62] == "<REQUEST> 31" &&
+                  owner.overflows == 0, "HostInterface back-to-back requests");
+        }
+
+        {
+            HAL_UART_AbortReceive(&huart2);
+
+            RecordingOwner owner;
+            HostInterface hostInterface(&owner);
+
+            // The buffer is lapped before anything is read, complete requests left are kept
+            sendToDevice(uart, "<A>\r\n" + filler + "\r\n<B>\r\n");
+            hostInterface.update();
+
+            check(owner.requests.size() == 1 && owner.requests[0] == "<B>" && owner.overflows == 1,
+                  "HostInterface lapped buffer");
+
+            sendToDevice(uart, "<C>\r\n");
+            hostInterface.update();
+
+            check(owner.requests.size() == 2 && owner.requests[1] == "<C>",
+                  "HostInterface recovery after lapped buffer");
+        }
+
+        {
+            HAL_UART_AbortReceive(&huart2);
+
+            RecordingOwner owner;
+            HostInterface hostInterface(&owner);
+
+            // The buffer is lapped while the first of two queued requests is handled
+            owner.onFirstRequest = [&] { sendToDevice(uart, filler); };
+
+            sendToDevice(uart, "<A>\r\n<B>\r\n");
+            hostInterface.update();
+
+            check(owner.requests.size() == 1 && owner.overflows == 1,
+                  "HostInterface lapped while busy");
+        }
+
+        {
+            HAL_UART_AbortReceive(&huart2);
+
+            RecordingOwner owner;
+            HostInterface hostInterface(&owner);
+
+            sendToDevice(uart, "<A>\r\n<B");
+            hostInterface.update();
+
+            // Reception stops on the error and is restarted by the interface
+            uart.raiseError(HAL_UART_ERROR_ORE);
+            hostInterface.update();
+            hostInterface.update();
+
+            sendToDevice(uart, ">\r\n<C>\r\n");
+            hostInterface.update();
+
+            check(owner.requests.size() == 2 && owner.requests[1] == "<C>" && owner.overflows == 1,
+                  "HostInterface restart after receive error");
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    auto flashContents(size_t length) -> ByteArray
+    {
+        const auto data = reinterpret_cast<const uint8_t*>(Config::FirmwareStartAddress);
+        return ByteArray(data, data + length);
+    }
+
+    // Rows may be revisited, but data already in flash can't be changed without erasing
+    void testProgrammer()
+    {
+        using Error = Programmer::ProgramError;
+
+        const uint32_t address = Config::FirmwareStartAddress;
+        const ByteArray data = makeRandomData(3 * Programmer::RowSize, 9);
+        const ByteArray changed = makeRandomData(16, 10);
+
+        Programmer programmer;
+
+        // The first two rows are complete and written, the third one is left pending
+        programmer.writeData(address, data.data(), 2 * Programmer::RowSize + 16);
+
+        const ByteArray written(data.begin(), data.begin() + 2 * Programmer::RowSize);
+        check(flashContents(written.size()) == written, "Programmer complete rows written");
+
+        try {
+            // Pending data may be changed, repeating data and filling gaps is fine
+            programmer.writeData(address + 2 * Programmer::RowSize, changed.data(), 16);
+            programmer.writeData(address + 2 * Programmer::RowSize + 16,
+                                 data.data() + 2 * Programmer::RowSize + 16,
+                                 Programmer::RowSize - 16);
+            programmer.writeData(address + 32, data.data() + 32, 16);
+
+            ByteArray expected = data;
+            std::copy(changed.begin(), changed.end(), expected.begin() + 2 * Programmer::RowSize);
+
+            check(flashContents(expected.size()) == expected, "Programmer revisited rows");
+        }
+        catch (const std::exception& e) {
+            check(false, std::string("Programmer revisit (") + e.what() + ")");
+        }
+
+        checkThrows<Error>([&] { programmer.writeData(address + 32, changed.data(), 16); },
+                           "Programmer change programmed data",
+                           [](const Error& e) {
+                               return e.type() == Error::Type::AlreadyProgrammed;
+                           });
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    // Data records of at most 16 bytes, each segment of 64 KiB preceded by its upper address
+    auto makeRecords(uint32_t address, const ByteArray& data) -> std::vector<std::string>
+    {
+        std::vector<std::string> records;
+        uint32_t upperAddress = ~0u;
+
+        for (size_t offset = 0; offset < data.size(); offset += 16)
+        {
+            const uint32_t recordAddress = address + offset;
+
+            if ((recordAddress >> 16) != upperAddress)
+            {
+                upperAddress = recordAddress >> 16;
+
+                const ByteArray upper = { static_cast<uint8_t>(upperAddress >> 8),
+                                          static_cast<uint8_t>(upperAddress) };
+                records.push_back(makeRecord(0x04, 0, upper));
+            }
+
+            const size_t length = std::min<size_t>(16, data.size() - offset);
+            const ByteArray bytes(data.begin() + offset, data.begin() + offset + length);
+
+            records.push_back(makeRecord(0x00, static_cast<uint16_t>(recordAddress), bytes));
+        }
+
+        return records;
+    }
+
+    // An upload abandoned without locking must not leave sectors behind that the next one
+    // takes for erased, as the host skips erasing them on devices erasing on write
+    void testBootloader()
+    {
+        const uint32_t address = Config::FirmwareStartAddress;
+        const size_t sectorSize = Config::FlashSectorSizes[Config::FirmwareStartSector] * 1024;
+
+        const ByteArray oldImage = makeRandomData(sectorSize + 4096, 11);
+        const ByteArray newImage = makeRandomData(sectorSize + 2048, 12);
+
+        const std::vector<std::string> oldRecords = makeRecords(address, oldImage);
+        const std::vector<std::string> newRecords = makeRecords(address, newImage);
+
+        Bootloader bootloader;
+
+        auto write = [&](const std::string& record) {
+            bootloader.writeHexRecord(std::span(record));
+        };
+
+        try {
+            bootloader.unlockFirmware();
+
+            for (const std::string& record : oldRecords)
+                write(record);
+
+            write(":00000001FF");
+            bootloader.lockFirmware();
+
+            check(Checksum::verify(Slot::Active), "Bootloader first image valid");
+
+            // Abandoned halfway into the second sector, with a row still pending
+            bootloader.unlockFirmware();
+
+            for (size_t i = 0; i < oldRecords.size() * 9 / 10; ++i)
+                write(oldRecords.at(i));
+
+            bootloader.unlockFirmware();
+            write(newRecords.front());
+
+            check(!Checksum::verify(Slot::Active), "Bootloader retry invalidates image");
+
+            for (size_t i = 1; i < newRecords.size(); ++i)
+                write(newRecords.at(i));
+
+            write(":00000001FF");
+            bootloader.lockFirmware();
+
+            check(flashContents(newImage.size()) == newImage, "Bootloader retried image");
+            check(Checksum::verify(Slot::Active), "Bootloader retried image valid");
+        }
+        catch (const std::exception& e) {
+            check(false, std::string("Bootloader retry (") + e.what() + ")");
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    // Operations of a delta update, relative to the start of the partition
+    struct Operation
+    {
+        uint32_t source;
+        uint32_t length;
+        ByteArray literals; // Copy if empty
+    };
+
+    // Applies the operations one block each, splitting long inserts
+    void applyPatch(Patcher* patcher, const std::vector<Operation>& operations)
+    {
+        static constexpr size_t MaximumInsert = Patcher::MaximumBlockSize - Patcher::HeaderSize - 1;
+
+        uint32_t offset = 0;
+
+        auto writeBlock = [&](const ByteArray& ops, uint32_t length) {
+            ByteArray block;
+            appendLittleEndian(&block, offset, 4);
+
+            const uint32_t crc = crc32_update_buffer(crc32_update_buffer(0, block.data(), 4),
+                                                     ops.data(), ops.size());
+            appendLittleEndian(&block, crc, 4);
+            block.insert(block.end(), ops.begin(), ops.end());
+
+            const std::string string = encodeBase64(block);
+            patcher->write(std::span(string));
+
+            offset += length;
+        };
+
+        for (const Operation& operation : operations)
+        {
+            if (operation.literals.empty())
+            {
+                ByteArray ops = { Patcher::CopyCode };
+                appendLittleEndian(&ops, operation.source, 4);
+                appendLittleEndian(&ops, operation.length, 2);
+
+                writeBlock(ops, operation.length);
+                continue;
+            }
+
+            for (size_t i = 0; i < operation.literals.size(); i += MaximumInsert)
+            {
+                const size_t count = std::min(MaximumInsert, operation.literals.size() - i);
+
+                ByteArray ops = { static_cast<uint8_t>(count) };
+                ops.insert(ops.end(), operation.literals.begin() + i,
+                           operation.literals.begin() + i + count);
+
+                writeBlock(ops, count);
+            }
+        }
+    }
+
+    auto buildTarget(const ByteArray& source, const std::vector<Operation>& operations)
+        -> ByteArray
+    {
+        ByteArray target;
+
+        for (const Operation& operation : operations)
+        {
+            if (operation.literals.empty())
+            {
+                target.insert(target.end(), source.begin() + operation.source,
+                              source.begin() + operation.source + operation.length);
+            }
+            else
+                target.insert(target.end(), operation.literals.begin(), operation.literals.end());
+        }
+
+        return target;
+    }
+
+    void programSource(const ByteArray& source)
+    {
+        Programmer programmer;
+        programmer.writeData(Config::FirmwareStartAddress, source.data(), source.size());
+
+        const uint32_t crc = crc32_update_buffer(0, source.data(), source.size());
+        check(programmer.commitImage({ static_cast<uint32_t>(source.size()), crc }),
+              "Patcher source image");
+    }
+
+    void testPatcher()
+    {
+        if constexpr (Config::ScratchSector == 0)
+        {
+            std::fprintf(stderr, "Patching disabled, skipping patch tests.\n");
+            return;
+        }
+
+        using Error = Patcher::Error;
+
+        Programmer probe;
+        const uint32_t firstSectorSize = probe.sectorAddress(1) - probe.sectorAddress(0);
+        const uint32_t sourceLength = std::min<uint32_t>(3 * firstSectorSize,
+                                                         Slot::Active.size() - 1024);
+
+        const ByteArray source = makeRandomData(sourceLength, 6);
+        const uint32_t sourceCrc = crc32_update_buffer(0, source.data(), source.size());
+
+        // Code inserted at the start shifts the rest of the first sector, which is then read
+        // back from scratch. Later sectors keep their offsets, apart from a few bytes copied
+        // from a sector that hasn't been rewritten yet and a changed tail.
+        const uint32_t shift = 100;
+        const uint32_t tail = sourceLength - 500;
+
+        const std::vector<Operation> operations = {
+            { 0, 0, makeRandomData(shift, 7) },
+            { 0, firstSectorSize - shift, {} },
+            { firstSectorSize, 1000, {} },
+            { tail, 64, {} },
+            { firstSectorSize + 1064, tail - firstSectorSize - 1064, {} },
+            { 0, 0, makeRandomData(300, 8) }
+        };
+
+        const ByteArray target = buildTarget(source, operations);
+        const uint32_t targetCrc = crc32_update_buffer(0, target.data(), target.size());
+        const Checksum::Record targetRecord = { static_cast<uint32_t>(target.size()), targetCrc };
+
+        programSource(source);
+
+        {
+            Programmer programmer;
+            Patcher patcher;
+
+            checkThrows<Error>([&] { patcher.begin(&programmer, sourceCrc + 1, targetRecord); },
+                               "Patcher source mismatch",
+                               [](const Error& e) {
+                                   return e.type() == Error::Type::SourceMismatch;
+                               });
+            try {
+                patcher.begin(&programmer, sourceCrc, targetRecord);
+                applyPatch(&patcher, operations);
+                patcher.finish();
+
+                check(flashContents(target.size()) == target, "Patcher target image");
+                check(Checksum::verify(Slot::Active), "Patcher target checksum");
+                check(Checksum::read(Slot::Active) == targetRecord, "Patcher target record");
+            }
+            catch (const std::exception& e) {
+                check(false, std::string("Patcher apply (") + e.what() + ")");
+            }
+        }
+
+        // Sectors that have already been rewritten can't be read from anymore
+        programSource(source);
+
+        {
+            Programmer programmer;
+            Patcher patcher;
+
+            const std::vector<Operation> invalidOperations = {
+                { 0, firstSectorSize + 100, {} },
+                { 0, 100, {} }
+            };
+
+            patcher.begin(&programmer, sourceCrc, { sourceLength, sourceCrc });
+
+            checkThrows<Error>([&] { applyPatch(&patcher, invalidOperations); },
+                               "Patcher copy from rewritten sector",
+                               [](const Error& e) {
+                                   return e.type() == Error::Type::InvalidPatch;
+                               });
+
+            check(!Checksum::verify(Slot::Active), "Patcher interrupted image invalid");
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main() -> int
+{
+    Simulation::Flash::Settings flashSettings;
+    flashSettings.baseAddress = Config::FlashBaseAddress;
+
+    for (uint32_t size : Config::FlashSectorSizes)
+        flashSettings.sectorSizes.push_back(size * 1024);
+
+    Simulation::Uart::Settings uartSettings;
+    uartSettings.baudrate = 0;
+    uartSettings.transport = Simulation::Uart::Transport::Memory;
+
+    try {
+        Simulation::Flash flash(flashSettings);
+        Simulation::Uart uart(uartSettings);
+
+        uart.attach(&huart2);
+
+        testCrcEngines();
+        testHexRecord();
+        testDecompressor();
+        testHostInterface(uart);
+        testProgrammer();
+        testBootloader();
+        testPatcher();
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    if (g_failures > 0)
+    {
+        std::fprintf(stderr, "%zu checks failed.\n", g_failures);
+        return 1;
+    }
+
+    std::printf("All checks passed.\n");
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,76 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace Benchmark {
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr auto MinimumDuration = std::chrono::milliseconds(200);
+
+    // Prevents the compiler from optimizing away results that are otherwise unused
+    template <typename T>
+    inline void keep(const T& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // Calls the function repeatedly for at least MinimumDuration, returns seconds per call
+    template <typename Function>
+    auto measure(Function&& function) -> double
+    {
+        function(); // Warm-up
+
+        size_t iterations = 0;
+        const auto start = Clock::now();
+        auto elapsed = Clock::duration();
+
+        do {
+            function();
+            ++iterations;
+            elapsed = Clock::now() - start;
+        } while (elapsed < MinimumDuration);
+
+        return std::chrono::duration<double>(elapsed).count() / iterations;
+    }
+
+    inline void printHeader()
+    {
+        std::printf("%-40s %12s %12s\n", "Benchmark", "Time [us]", "MiB/s");
+    }
+
+    inline void printResult(const std::string& name, double seconds, size_t bytes = 0)
+    {
+        const double throughput = bytes ? bytes / seconds / (1024.0 * 1024.0) : 0.0;
+        std::printf("%-40s %12.2f %12.1f\n", name.c_str(), seconds * 1e6, throughput);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
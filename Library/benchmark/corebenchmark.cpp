@@ -0,0 +1,193 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "benchmark.h"
+#include "firmwarearchiveprivate.h"
+#include "syntheticpackage.h"
+
+#include <FirmwareUpdater/Core/firmwaremanager.h>
+
+#include <fstream>
+#include <random>
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace FirmwareUpdater;
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr size_t Sizes[] = { 64 * 1024, 256 * 1024, 1024 * 1024, 2 * 1024 * 1024 };
+    constexpr size_t RepositorySizes[] = { 10, 100, 1000, 10000 };
+
+    constexpr uint32_t StartAddress = 0x08008000;
+
+    constexpr const char* BoardName = "Board0";
+    constexpr const char* HardwareVersion = "1.0";
+    constexpr const char* PackagerName = "CoreBenchmark";
+
+    auto makeRandomData(size_t size) -> ByteArray
+    {
+        std::mt19937 random(size);
+        ByteArray data(size);
+
+        for (uint8_t& byte : data)
+            byte = static_cast<uint8_t>(random());
+
+        return data;
+    }
+
+    // Populates a repository with packages for 100 boards of up to 100 versions each
+    void makeRepository(const std::filesystem::path& path, size_t packageCount)
+    {
+        std::filesystem::create_directory(path);
+
+        for (size_t i = 0; i < packageCount; ++i)
+        {
+            const std::string filename = "Board" + std::to_string(i % 100) + "-"
+                                       + HardwareVersion + "-"
+                                       + std::to_string(i / 1000 % 10) + "."
+                                       + std::to_string(i / 100 % 10) + ".zip";
+
+            std::ofstream(path / filename);
+        }
+    }
+
+    void benchmarkArchive(size_t size, EVP_PKEY* pkey, const std::string& publicKey)
+    {
+        using namespace FirmwareArchivePrivate;
+        using namespace SyntheticPackage;
+
+        const std::string suffix = "/" + std::to_string(size);
+
+        const TemporaryDirectory dir;
+        const std::filesystem::path filename = dir.path() / "Package.zip";
+
+        const std::string hexFile = makeHexFile(StartAddress, size);
+        create(filename, hexFile, makeMetadata(BoardName, HardwareVersion, "1.0", PackagerName),
+               pkey);
+
+        const double archiveTime = Benchmark::measure([&] {
+            const FirmwareArchive archive(filename.string());
+            Benchmark::keep(archive);
+        });
+
+        Benchmark::printResult("FirmwareArchive" + suffix, archiveTime,
+                               std::filesystem::file_size(filename));
+
+        const ByteArray encoded = encodeBase64(makeRandomData(size));
+
+        const double base64Time = Benchmark::measure([&] {
+            Benchmark::keep(base64Decode(encoded));
+        });
+
+        Benchmark::printResult("base64Decode" + suffix, base64Time, encoded.size());
+
+        const ByteArray data = makeRandomData(size);
+        const ByteArray signature = base64Decode(SyntheticPackage::sign(pkey, data));
+
+        const double uncachedTime = Benchmark::measure([&] {
+            verifySignature(data, signature, parsePublicKey(publicKey).get());
+        });
+
+        Benchmark::printResult("verifySignature/uncached" + suffix, uncachedTime, data.size());
+
+        const PkeyGuard key = parsePublicKey(publicKey);
+
+        const double cachedTime = Benchmark::measure([&] {
+            verifySignature(data, signature, key.get());
+        });
+
+        Benchmark::printResult("verifySignature/cached" + suffix, cachedTime, data.size());
+
+        const ByteArray hexData(hexFile.begin(), hexFile.end());
+
+        const double hexTime = Benchmark::measure([&] {
+            FirmwareArchive::DataRecordList dataRecords;
+            Benchmark::keep(parseHexFile(hexData, &dataRecords));
+        });
+
+        Benchmark::printResult("parseHexFile" + suffix, hexTime, hexData.size());
+    }
+
+    void benchmarkMetadata()
+    {
+        const std::string metadata = SyntheticPackage::makeMetadata(BoardName, HardwareVersion,
+                                                                    "1.0", PackagerName);
+        const ByteArray data(metadata.begin(), metadata.end());
+
+        const double time = Benchmark::measure([&] {
+            Benchmark::keep(FirmwareArchivePrivate::parseMetadata(data));
+        });
+
+        Benchmark::printResult("parseMetadata", time, data.size());
+    }
+
+    void benchmarkRepository(size_t packageCount)
+    {
+        const SyntheticPackage::TemporaryDirectory dir;
+        makeRepository(dir.path() / "repository", packageCount);
+
+        // The repository is looked up relative to the working directory
+        const std::filesystem::path previousPath = std::filesystem::current_path();
+        std::filesystem::current_path(dir.path());
+
+        const double time = Benchmark::measure([&] {
+            Benchmark::keep(FirmwareManager::getAvailableVersion(BoardName, HardwareVersion));
+        });
+
+        std::filesystem::current_path(previousPath);
+
+        Benchmark::printResult("getAvailableVersion/" + std::to_string(packageCount), time);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main() -> int
+{
+    try {
+        const SyntheticPackage::PkeyGuard pkey = SyntheticPackage::generateKey();
+        const std::string publicKey = SyntheticPackage::encodePublicKey(pkey.get());
+
+        FirmwareArchive::registerPublicKey(PackagerName, publicKey);
+
+        Benchmark::printHeader();
+
+        for (size_t size : Sizes)
+            benchmarkArchive(size, pkey.get(), publicKey);
+
+        benchmarkMetadata();
+
+        for (size_t count : RepositorySizes)
+            benchmarkRepository(count);
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
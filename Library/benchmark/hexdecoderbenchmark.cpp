@@ -0,0 +1,100 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "benchmark.h"
+#include "hexdecoder.h"
+
+#include <random>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr size_t Sizes[] = { 16, 64, 256, 64 * 1024, 2 * 1024 * 1024 };
+
+    auto implementationName(HexDecoder::Implementation implementation) -> const char*
+    {
+        switch (implementation)
+        {
+        case HexDecoder::Implementation::SSE2:
+            return "SSE2";
+
+        case HexDecoder::Implementation::AVX2:
+            return "AVX2";
+
+        default:
+            return "Scalar";
+        }
+    }
+
+    auto makeInput(size_t count) -> std::string
+    {
+        static constexpr char Digits[] = "0123456789ABCDEF";
+
+        std::mt19937 random(count);
+        std::string input(2 * count, '0');
+
+        for (char& c : input)
+            c = Digits[random() % 16];
+
+        return input;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main() -> int
+{
+    using Implementation = HexDecoder::Implementation;
+
+    Benchmark::printHeader();
+
+    for (size_t size : Sizes)
+    {
+        const std::string input = makeInput(size);
+        std::vector<uint8_t> output(size);
+
+        for (auto implementation : { Implementation::Scalar,
+                                     Implementation::SSE2,
+                                     Implementation::AVX2 })
+        {
+            if (!HexDecoder::isSupported(implementation))
+                continue;
+
+            const double time = Benchmark::measure([&] {
+                uint8_t checksum = 0;
+                HexDecoder::decode(input.data(), size, output.data(), &checksum, implementation);
+                Benchmark::keep(checksum);
+            });
+
+            const std::string name = std::string("decode/") + implementationName(implementation)
+                                                            + "/" + std::to_string(size);
+
+            Benchmark::printResult(name, time, input.size());
+        }
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,288 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "syntheticpackage.h"
+
+#include <openssl/encoder.h>
+#include <openssl/rsa.h>
+
+#include <zip.h>
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+
+#include <stdlib.h>
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace SyntheticPackage;
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    auto makeRecord(uint8_t type, uint16_t address, const uint8_t* data, size_t size)
+        -> std::string
+    {
+        static constexpr char Digits[] = "0123456789ABCDEF";
+
+        std::string record = ":";
+        uint8_t checksum = 0;
+
+        auto append = [&](uint8_t value) {
+            record += Digits[value >> 4];
+            record += Digits[value & 0x0f];
+            checksum += value;
+        };
+
+        append(static_cast<uint8_t>(size));
+        append(address >> 8);
+        append(address & 0xff);
+        append(type);
+
+        for (size_t i = 0; i < size; ++i)
+            append(data[i]);
+
+        append(static_cast<uint8_t>(-checksum));
+
+        return record + "\n";
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+TemporaryDirectory::TemporaryDirectory()
+{
+    std::string path = std::filesystem::temp_directory_path() / "firmwareupdaterXXXXXX";
+
+    if (!mkdtemp(path.data()))
+        throw Error("Unable to create temporary directory.");
+
+    m_path = path;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+TemporaryDirectory::~TemporaryDirectory()
+{
+    std::error_code error;
+    std::filesystem::remove_all(m_path, error);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto SyntheticPackage::makeHexFile(uint32_t startAddress, size_t imageSize, size_t recordSize)
+    -> std::string
+{
+    std::mt19937 random(imageSize);
+    std::vector<uint8_t> image(imageSize);
+
+    for (uint8_t& byte : image)
+        byte = static_cast<uint8_t>(random());
+
+    std::string hex;
+    uint32_t upperAddress = ~0u;
+    size_t offset = 0;
+
+    while (offset < imageSize)
+    {
+        const uint32_t address = startAddress + offset;
+
+        if ((address >> 16) != upperAddress)
+        {
+            upperAddress = address >> 16;
+
+            const uint8_t data[] = { uint8_t(upperAddress >> 8), uint8_t(upperAddress) };
+            hex += makeRecord(0x04, 0, data, sizeof(data));
+        }
+
+        // Records must not cross a 64 KiB boundary
+        const size_t size = std::min({ recordSize, imageSize - offset,
+                                       size_t(0x10000 - (address & 0xffff)) });
+
+        hex += makeRecord(0x00, address & 0xffff, &image.at(offset), size);
+        offset += size;
+    }
+
+    hex += makeRecord(0x01, 0, nullptr, 0);
+
+    return hex;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto SyntheticPackage::makeMetadata(const std::string& boardName,
+                                    const std::string& hardwareVersion,
+                                    const std::string& firmwareVersion,
+                                    const std::string& packager) -> std::string
+{
+    return "BoardName = "       + boardName       + "\n"
+           "HardwareVersion = " + hardwareVersion + "\n"
+           "FirmwareVersion = " + firmwareVersion + "\n"
+           "ReleaseDate = 1970-01-01\n"
+           "Packager = "        + packager        + "\n";
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto SyntheticPackage::generateKey(int bits) -> PkeyGuard
+{
+    PkeyGuard pkey(EVP_RSA_gen(bits), EVP_PKEY_free);
+
+    if (!pkey)
+        throw Error("Unable to generate signing key.");
+
+    return pkey;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto SyntheticPackage::encodePublicKey(EVP_PKEY* pkey) -> std::string
+{
+    OSSL_ENCODER_CTX* ctx = OSSL_ENCODER_CTX_new_for_pkey(pkey, EVP_PKEY_PUBLIC_KEY, "PEM",
+                                                          "type-specific", nullptr);
+    unsigned char* data = nullptr;
+    size_t size = 0;
+
+    const bool success = ctx && OSSL_ENCODER_to_data(ctx, &data, &size) > 0;
+    OSSL_ENCODER_CTX_free(ctx);
+
+    if (!success)
+        throw Error("Unable to encode public key.");
+
+    std::string key(reinterpret_cast<char*>(data), size);
+    OPENSSL_free(data);
+
+    return key;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto SyntheticPackage::encodeBase64(const ByteArray& data, size_t lineLength) -> ByteArray
+{
+    ByteArray encoded((data.size()/3 + 1) * 4 + 1); // Add byte for '\0'
+    encoded.resize(EVP_EncodeBlock(encoded.data(), data.data(), static_cast<int>(data.size())));
+
+    ByteArray result;
+
+    for (size_t i = 0; i < encoded.size(); i += lineLength)
+    {
+        const size_t size = std::min(lineLength, encoded.size() - i);
+
+        result.insert(result.end(), encoded.begin() + i, encoded.begin() + i + size);
+        result.push_back('\n');
+    }
+
+    return result;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto SyntheticPackage::sign(EVP_PKEY* pkey, const ByteArray& data) -> ByteArray
+{
+    using CtxGuard = std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>;
+
+    CtxGuard ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+
+    if (EVP_DigestSignInit(ctx.get(), nullptr, EVP_sha256(), nullptr, pkey) <= 0)
+        throw Error("Unable to initialize OpenSSL digest signing.");
+
+    size_t siglen = 0;
+
+    if (EVP_DigestSign(ctx.get(), nullptr, &siglen, data.data(), data.size()) <= 0)
+        throw Error("Unable to determine length of signature.");
+
+    ByteArray signature(siglen);
+
+    if (EVP_DigestSign(ctx.get(), signature.data(), &siglen, data.data(), data.size()) <= 0)
+        throw Error("Signature of firmware data failed.");
+
+    signature.resize(siglen);
+
+    return encodeBase64(signature);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto SyntheticPackage::readFile(const std::filesystem::path& filename) -> ByteArray
+{
+    std::ifstream file(filename, std::ios::binary);
+
+    if (!file)
+        throw Error("Unable to open " + filename.string() + " for reading.");
+
+    return ByteArray(std::istreambuf_iterator<char>(file), {});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void SyntheticPackage::writeZipFile(const std::filesystem::path& filename, const FileList& files)
+{
+    int error = 0;
+    zip_t* handle = zip_open(filename.c_str(), ZIP_CREATE | ZIP_TRUNCATE, &error);
+
+    if (!handle)
+        throw Error("Unable to create " + filename.string() + ".");
+
+    for (const auto& [name, data] : files)
+    {
+        zip_source_t* source = zip_source_buffer(handle, data.data(), data.size(), 0);
+
+        if (!source || zip_file_add(handle, name.c_str(), source, 0) < 0)
+        {
+            zip_source_free(source);
+            zip_discard(handle);
+            throw Error("Unable to add " + name + " to " + filename.string() + ".");
+        }
+    }
+
+    // Buffers are only read when the archive is closed
+    if (zip_close(handle) < 0)
+    {
+        zip_discard(handle);
+        throw Error("Unable to write " + filename.string() + ".");
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void SyntheticPackage::create(const std::filesystem::path& filename, const std::string& hexFile,
+                              const std::string& metadata, EVP_PKEY* pkey)
+{
+    const TemporaryDirectory dir;
+    const std::filesystem::path dataFile = dir.path() / "Data.zip";
+
+    writeZipFile(dataFile, {
+        { "Data.hex", ByteArray(hexFile.begin(), hexFile.end())   },
+        { "METADATA", ByteArray(metadata.begin(), metadata.end()) }
+    });
+
+    const ByteArray data = readFile(dataFile);
+
+    writeZipFile(filename, {
+        { "Data.zip",     data             },
+        { "Data.zip.sig", sign(pkey, data) }
+    });
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,86 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <openssl/evp.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Generates signed firmware packages with random content, in the same layout as produced by
+// the packager, so that benchmarks don't depend on repository or key files.
+
+namespace SyntheticPackage {
+
+    using ByteArray = std::vector<uint8_t>;
+    using FileList = std::vector<std::pair<std::string, ByteArray>>;
+    using PkeyGuard = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+
+    using Error = std::runtime_error;
+
+    // Creates a unique directory that is removed again with all its content
+    class TemporaryDirectory
+    {
+    public:
+        TemporaryDirectory();
+        ~TemporaryDirectory();
+
+        TemporaryDirectory(const TemporaryDirectory&) = delete;
+        auto operator=(const TemporaryDirectory&) = delete;
+
+        auto path() const -> const std::filesystem::path& { return m_path; }
+
+    private:
+        std::filesystem::path m_path;
+    };
+
+    auto makeHexFile(uint32_t startAddress, size_t imageSize, size_t recordSize = 16)
+        -> std::string;
+
+    auto makeMetadata(const std::string& boardName, const std::string& hardwareVersion,
+                      const std::string& firmwareVersion, const std::string& packager)
+        -> std::string;
+
+    auto generateKey(int bits = 4096) -> PkeyGuard;
+
+    // Returns the public key in the PKCS#1 PEM format expected by FirmwareArchive
+    auto encodePublicKey(EVP_PKEY* pkey) -> std::string;
+
+    auto encodeBase64(const ByteArray& data, size_t lineLength = 65) -> ByteArray;
+    auto sign(EVP_PKEY* pkey, const ByteArray& data) -> ByteArray; // Base64 encoded
+
+    auto readFile(const std::filesystem::path& filename) -> ByteArray;
+    void writeZipFile(const std::filesystem::path& filename, const FileList& files);
+
+    // Writes a complete package consisting of the signed Data.zip and Data.zip.sig
+    void create(const std::filesystem::path& filename, const std::string& hexFile,
+                const std::string& metadata, EVP_PKEY* pkey);
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,427 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+// Measures the throughput of a complete firmware upload. By default, a BootloaderSimulator
+// process is spawned and the upload is run over its pseudo-terminal. A synthetic image of the
+// requested size is packaged and signed on the fly, so no repository or key files are needed.
+// Results are printed as a single JSON object to allow comparisons against a baseline.
+
+#include "nucleocomponent.h"
+#include "syntheticpackage.h"
+
+#include <FirmwareUpdater/Core/firmwarearchive.h>
+#include <FirmwareUpdater/Core/uploadjob.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include <getopt.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace FirmwareUpdater;
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using Error = std::runtime_error;
+
+    constexpr const char* PackagerName = "UploadBenchmark";
+
+    struct Options
+    {
+        std::string simulator = "BootloaderSimulator";
+        std::string port; // Connect to an existing device rather than spawning the simulator
+
+        std::string baudrate = "115200";
+        std::string latency = "0";
+        std::string eraseTime = "0";
+        std::string programTime = "0";
+
+        size_t imageSize = 64 * 1024;
+        size_t recordSize = 16;
+    };
+
+    // -------------------------------------------------------------------------------------- //
+
+    class Simulator
+    {
+    public:
+        Simulator(const Options& options)
+        {
+            const std::vector<std::string> arguments = {
+                options.simulator,
+                "--baudrate",     options.baudrate,
+                "--latency",      options.latency,
+                "--erase-time",   options.eraseTime,
+                "--program-time", options.programTime
+            };
+
+            std::vector<char*> argv;
+
+            for (const std::string& argument : arguments)
+                argv.push_back(const_cast<char*>(argument.c_str()));
+
+            argv.push_back(nullptr);
+
+            int fds[2] = {};
+
+            if (pipe(fds) < 0)
+                throw Error("Unable to create pipe for simulator output.");
+
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+            posix_spawn_file_actions_addclose(&actions, fds[0]);
+
+            const int result = posix_spawnp(&m_pid, argv.front(), &actions, nullptr,
+                                            argv.data(), environ);
+
+            posix_spawn_file_actions_destroy(&actions);
+            close(fds[1]);
+
+            if (result != 0)
+            {
+                close(fds[0]);
+                throw Error("Unable to start " + options.simulator + ".");
+            }
+
+            // The simulator prints the name of its pseudo-terminal first
+            char c = 0;
+
+            while (read(fds[0], &c, 1) == 1 && c != '\n')
+                m_port += c;
+
+            close(fds[0]);
+
+            if (m_port.empty())
+            {
+                stop();
+                throw Error("Simulator didn't report its serial port.");
+            }
+        }
+
+        ~Simulator() { stop(); }
+
+        Simulator(const Simulator&) = delete;
+        auto operator=(const Simulator&) = delete;
+
+        auto port() const -> const std::string& { return m_port; }
+
+    private:
+        void stop()
+        {
+            if (m_pid <= 0)
+                return;
+
+            kill(m_pid, SIGTERM);
+            waitpid(m_pid, nullptr, 0);
+
+            m_pid = 0;
+        }
+
+    private:
+        pid_t m_pid = 0;
+        std::string m_port;
+    };
+
+    // -------------------------------------------------------------------------------------- //
+
+    struct Metrics
+    {
+        size_t records = 0;
+        size_t payloadBytes = 0;
+
+        double totalTime = 0.0;
+        double eraseTime = 0.0;
+        double writeTime = 0.0;
+
+        Device::Statistics traffic;
+    };
+
+    // -------------------------------------------------------------------------------------- //
+
+    void printUsage(const char* program)
+    {
+        std::cerr <<
+            "Usage: " << program << " [options]\n"
+            "\n"
+            "Uploads a synthetic firmware image and prints throughput metrics as JSON.\n"
+            "\n"
+            "Options:\n"
+            "  --simulator <path>     Simulator executable (default: BootloaderSimulator)\n"
+            "  --port <name>          Use an existing device relative to /dev instead\n"
+            "  --baudrate <rate>      Emulated baud rate, 0 for unlimited (default: 115200)\n"
+            "  --latency <us>         Emulated latency per response (default: 0)\n"
+            "  --erase-time <us>      Erase time per KiB of flash (default: 0)\n"
+            "  --program-time <us>    Time per program operation (default: 0)\n"
+            "  --image-size <KiB>     Size of the firmware image (default: 64)\n"
+            "  --record-size <bytes>  Data bytes per hex record, at most 255 (default: 16)\n"
+            "  --help                 Show this help\n";
+    }
+
+    // -------------------------------------------------------------------------------------- //
+
+    auto parseOptions(int argc, char* argv[], Options* options) -> bool
+    {
+        enum { SimulatorPath, Port, Baudrate, Latency, EraseTime, ProgramTime,
+               ImageSize, RecordSize, Help };
+
+        static const option longOptions[] = {
+            { "simulator",    required_argument, nullptr, SimulatorPath },
+            { "port",         required_argument, nullptr, Port          },
+            { "baudrate",     required_argument, nullptr, Baudrate      },
+            { "latency",      required_argument, nullptr, Latency       },
+            { "erase-time",   required_argument, nullptr, EraseTime     },
+            { "program-time", required_argument, nullptr, ProgramTime   },
+            { "image-size",   required_argument, nullptr, ImageSize     },
+            { "record-size",  required_argument, nullptr, RecordSize    },
+            { "help",         no_argument,       nullptr, Help          },
+            { nullptr,        0,                 nullptr, 0             }
+        };
+
+        int option = 0;
+
+        while ((option = getopt_long(argc, argv, "", longOptions, nullptr)) != -1)
+        {
+            switch (option)
+            {
+            case SimulatorPath:
+                options->simulator = optarg;
+                break;
+
+            case Port:
+                options->port = optarg;
+                break;
+
+            case Baudrate:
+                options->baudrate = std::to_string(std::stoul(optarg));
+                break;
+
+            case Latency:
+                options->latency = std::to_string(std::stoul(optarg));
+                break;
+
+            case EraseTime:
+                options->eraseTime = std::to_string(std::stoul(optarg));
+                break;
+
+            case ProgramTime:
+                options->programTime = std::to_string(std::stoul(optarg));
+                break;
+
+            case ImageSize:
+                options->imageSize = std::stoul(optarg) * 1024;
+                break;
+
+            case RecordSize:
+                options->recordSize = std::stoul(optarg);
+                break;
+
+            default:
+                return false;
+            }
+        }
+
+        const bool recordSizeValid = options->recordSize > 0 && options->recordSize <= 255;
+
+        return optind == argc && options->imageSize > 0 && recordSizeValid;
+    }
+
+    // -------------------------------------------------------------------------------------- //
+
+    auto createArchive(const Device::BootloaderInfo& info, const Options& options)
+        -> FirmwareArchivePtr
+    {
+        if (info.firmwareEndAddress > info.firmwareStartAddress &&
+            options.imageSize > info.firmwareEndAddress - info.firmwareStartAddress)
+        {
+            throw Error("Image size exceeds the device's firmware partition.");
+        }
+
+        using namespace SyntheticPackage;
+
+        const std::string hex = makeHexFile(info.firmwareStartAddress,
+                                            options.imageSize, options.recordSize);
+
+        const std::string metadata = makeMetadata(info.boardName, info.hardwareVersion,
+                                                  "Benchmark", PackagerName);
+
+        const PkeyGuard pkey = generateKey();
+        FirmwareArchive::registerPublicKey(PackagerName, encodePublicKey(pkey.get()));
+
+        const TemporaryDirectory dir;
+        const std::filesystem::path packageFile = dir.path() / "Package.zip";
+
+        create(packageFile, hex, metadata, pkey.get());
+
+        return std::make_shared<FirmwareArchive>(packageFile.string());
+    }
+
+    // -------------------------------------------------------------------------------------- //
+
+    auto seconds(Clock::duration duration) -> double
+    {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    // -------------------------------------------------------------------------------------- //
+
+    auto runUpload(const std::string& port, const Options& options) -> Metrics
+    {
+        Device device(port.c_str());
+        NucleoComponent component(&device);
+
+        if (component.getBootMode() != Component::BootMode::Bootloader)
+            component.launchBootloader();
+
+        const FirmwareArchivePtr archive = createArchive(device.getBootloaderInfo(), options);
+
+        UploadJob job(&component, archive);
+
+        Metrics metrics;
+
+        for (const FirmwareArchive::DataRecord& record : archive->dataRecords())
+        {
+            ++metrics.records;
+            metrics.payloadBytes += record.length;
+        }
+
+        device.resetStatistics();
+
+        const auto start = Clock::now();
+        auto eraseEnd = start;
+        auto writeEnd = start;
+
+        bool erased = false;
+
+        // Devices erasing on write report completion of the erase phase right away, and the
+        // erase time is then part of the write time
+        job.run([&](int erase, int, int) {
+            const auto now = Clock::now();
+
+            if (!erased)
+            {
+                eraseEnd = now;
+                erased = (erase == 100);
+            }
+
+            writeEnd = now;
+        });
+
+        metrics.totalTime = seconds(Clock::now() - start);
+        metrics.eraseTime = seconds(eraseEnd - start);
+        metrics.writeTime = seconds(writeEnd - eraseEnd);
+        metrics.traffic = device.statistics();
+
+        return metrics;
+    }
+
+    // -------------------------------------------------------------------------------------- //
+
+    void printMetrics(const Options& options, const Metrics& metrics)
+    {
+        const Device::Statistics& traffic = metrics.traffic;
+        const size_t wireBytes = traffic.bytesSent + traffic.bytesReceived;
+
+        const double recordRate = metrics.writeTime > 0.0 ? metrics.records / metrics.writeTime
+                                                          : 0.0;
+        const double payloadRate = metrics.totalTime > 0.0 ? metrics.payloadBytes / metrics.totalTime
+                                                           : 0.0;
+        const double efficiency = wireBytes ? double(metrics.payloadBytes) / wireBytes : 0.0;
+
+        std::printf("{\n"
+                    "  \"baudrate\": %s,\n"
+                    "  \"latency_us\": %s,\n"
+                    "  \"erase_time_us_per_kib\": %s,\n"
+                    "  \"program_time_us\": %s,\n"
+                    "  \"image_size\": %zu,\n"
+                    "  \"record_size\": %zu,\n"
+                    "  \"records\": %zu,\n"
+                    "  \"payload_bytes\": %zu,\n"
+                    "  \"requests\": %zu,\n"
+                    "  \"retries\": %zu,\n"
+                    "  \"bytes_sent\": %zu,\n"
+                    "  \"bytes_received\": %zu,\n"
+                    "  \"wire_efficiency\": %.4f,\n"
+                    "  \"records_per_second\": %.1f,\n"
+                    "  \"payload_bytes_per_second\": %.1f,\n"
+                    "  \"erase_time_s\": %.6f,\n"
+                    "  \"write_time_s\": %.6f,\n"
+                    "  \"total_time_s\": %.6f\n"
+                    "}\n",
+                    options.baudrate.c_str(), options.latency.c_str(),
+                    options.eraseTime.c_str(), options.programTime.c_str(),
+                    options.imageSize, options.recordSize,
+                    metrics.records, metrics.payloadBytes,
+                    traffic.requests, traffic.retries,
+                    traffic.bytesSent, traffic.bytesReceived,
+                    efficiency, recordRate, payloadRate,
+                    metrics.eraseTime, metrics.writeTime, metrics.totalTime);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main(int argc, char* argv[]) -> int
+{
+    Options options;
+
+    try {
+        if (!parseOptions(argc, argv, &options))
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::unique_ptr<Simulator> simulator;
+        std::string port = options.port;
+
+        if (port.empty())
+        {
+            simulator = std::make_unique<Simulator>(options);
+            port = simulator->port();
+        }
+
+        printMetrics(options, runUpload(port, options));
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,94 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#include <FirmwareUpdater/Core/component.h>
+
+#include <stdexcept>
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace FirmwareUpdater;
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Component::eraseSectors(size_t first, size_t count, const SectorFunction& erased)
+{
+    for (size_t sector = first; sector < first + count; ++sector)
+    {
+        eraseSector(sector);
+
+        if (erased)
+            erased(sector);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Component::writeCompressedBlock(const CompressedBlock&)
+{
+    throw std::runtime_error("Compressed blocks not supported by component.");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Component::beginPatch(uint32_t, uint32_t, uint32_t) -> bool
+{
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Component::writePatchBlock(const PatchBlock&)
+{
+    throw std::runtime_error("Delta updates not supported by component.");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Component::finishPatch()
+{
+    throw std::runtime_error("Delta updates not supported by component.");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Component::getStagingInfo() const -> std::optional<StagingInfo>
+{
+    return std::nullopt;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Component::getStagedFirmwareValid() const -> bool
+{
+    throw std::runtime_error("Staging not supported by component.");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Component::installFirmware()
+{
+    throw std::runtime_error("Staging not supported by component.");
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,261 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "compressor.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr size_t WindowSize = 1024;
+    constexpr size_t MinimumMatchLength = 3;
+    constexpr size_t MaximumMatchLength = MinimumMatchLength + 63;
+
+    // Longer chains find slightly better matches on large images at the expense of speed
+    constexpr size_t MaximumChainLength = 128;
+
+    constexpr size_t HashBits = 12;
+    constexpr int32_t NoPosition = -1;
+
+    constexpr auto makeCrcTable() -> std::array<uint32_t, 256>
+    {
+        std::array<uint32_t, 256> table = {};
+
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+
+            table[i] = crc;
+        }
+
+        return table;
+    }
+
+    constexpr std::array<uint32_t, 256> CrcTable = makeCrcTable();
+
+    struct Match
+    {
+        size_t distance = 0;
+        size_t length = 0;
+    };
+
+    // ------------------------------------------------------------------------------------------ //
+
+    class MatchFinder
+    {
+    public:
+        MatchFinder(const std::vector<uint8_t>& stream)
+            : m_stream(stream),
+              m_previous(stream.size(), NoPosition)
+        {
+            m_heads.fill(NoPosition);
+        }
+
+        // Finds the longest match for the data at position, ending no later than end
+        auto find(size_t position, size_t end) const -> Match
+        {
+            const size_t maximumLength = std::min(MaximumMatchLength, end - position);
+
+            Match best;
+
+            if (maximumLength < MinimumMatchLength)
+                return best;
+
+            int32_t candidate = m_heads[hash(position)];
+
+            for (size_t i = 0; i < MaximumChainLength && candidate != NoPosition; ++i)
+            {
+                const size_t distance = position - candidate;
+
+                // Chains are ordered by position, so all further candidates are out of reach
+                if (distance > WindowSize)
+                    break;
+
+                size_t length = 0;
+
+                while (length < maximumLength
+                       && m_stream[candidate + length] == m_stream[position + length])
+                {
+                    ++length;
+                }
+
+                if (length > best.length)
+                {
+                    best = { distance, length };
+
+                    if (length == maximumLength)
+                        break;
+                }
+
+                candidate = m_previous[candidate];
+            }
+
+            if (best.length < MinimumMatchLength)
+                return {};
+
+            return best;
+        }
+
+        void insert(size_t position)
+        {
+            if (position + MinimumMatchLength > m_stream.size())
+                return;
+
+            const size_t index = hash(position);
+
+            m_previous[position] = m_heads[index];
+            m_heads[index] = static_cast<int32_t>(position);
+        }
+
+    private:
+        auto hash(size_t position) const -> size_t
+        {
+            const uint32_t value = (m_stream[position] << 16) | (m_stream[position + 1] << 8)
+                                   | m_stream[position + 2];
+
+            return (value * 2654435761u) >> (32 - HashBits);
+        }
+
+    private:
+        const std::vector<uint8_t>& m_stream;
+
+        std::array<int32_t, 1 << HashBits> m_heads;
+        std::vector<int32_t> m_previous;
+    };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Compressor::compress(const std::vector<Segment>& segments,
+                          size_t blockSize, size_t payloadSize) -> std::vector<Block>
+{
+    // A flag byte and a match must fit, otherwise no progress can be made
+    if (blockSize == 0 || payloadSize < 3)
+        throw std::invalid_argument("Block size too small for compression.");
+
+    // The data in the order the device decompresses it, so matches can reach into earlier blocks
+    std::vector<uint8_t> stream;
+
+    for (const Segment& segment : segments)
+        stream.insert(stream.end(), segment.data.begin(), segment.data.end());
+
+    MatchFinder finder(stream);
+    std::vector<Block> blocks;
+
+    size_t position = 0;
+
+    for (const Segment& segment : segments)
+    {
+        const size_t segmentStart = position;
+        const size_t segmentEnd = position + segment.data.size();
+
+        while (position < segmentEnd)
+        {
+            const size_t blockStart = position;
+            const size_t blockEnd = std::min(segmentEnd, blockStart + blockSize);
+
+            Block block = {};
+            block.address = segment.address + static_cast<uint32_t>(blockStart - segmentStart);
+
+            size_t flagIndex = 0;
+            size_t itemCount = 8;
+
+            while (position < blockEnd)
+            {
+                const Match match = finder.find(position, blockEnd);
+                const size_t itemSize = (match.length > 0) ? 2 : 1;
+                const size_t flagSize = (itemCount == 8) ? 1 : 0;
+
+                if (block.data.size() + flagSize + itemSize > payloadSize)
+                    break;
+
+                if (itemCount == 8)
+                {
+                    flagIndex = block.data.size();
+                    block.data.push_back(0);
+                    itemCount = 0;
+                }
+
+                size_t length = 1;
+
+                if (match.length > 0)
+                {
+                    const uint16_t value = static_cast<uint16_t>(((match.distance - 1) << 6)
+                                                                 | (match.length - 3));
+                    block.data.push_back(static_cast<uint8_t>(value >> 8));
+                    block.data.push_back(static_cast<uint8_t>(value));
+
+                    length = match.length;
+                }
+                else
+                {
+                    block.data[flagIndex] |= (1 << itemCount);
+                    block.data.push_back(stream[position]);
+                }
+
+                ++itemCount;
+
+                for (size_t i = 0; i < length; ++i)
+                    finder.insert(position + i);
+
+                position += length;
+            }
+
+            block.length = static_cast<uint32_t>(position - blockStart);
+            // The checksum also protects the address and length fields of the block header
+            const uint8_t header[] = {
+                static_cast<uint8_t>(block.address),
+                static_cast<uint8_t>(block.address >> 8),
+                static_cast<uint8_t>(block.address >> 16),
+                static_cast<uint8_t>(block.address >> 24),
+                static_cast<uint8_t>(block.length),
+                static_cast<uint8_t>(block.length >> 8)
+            };
+
+            block.crc = checksum(checksum(0, header, sizeof(header)),
+                                 stream.data() + blockStart, block.length);
+
+            blocks.push_back(std::move(block));
+        }
+    }
+
+    return blocks;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Compressor::checksum(uint32_t crc, const uint8_t* data, size_t length) -> uint32_t
+{
+    for (size_t i = 0; i < length; ++i)
+        crc = (crc >> 8) ^ CrcTable[(crc ^ data[i]) & 0xff];
+
+    return crc;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,54 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <FirmwareUpdater/Core/component.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compresses firmware images into blocks for the bootloader's Decompressor, using LZSS with a
+// 1 KiB window that spans all blocks of an upload. Matches are searched greedily along hash
+// chains, which is fast enough to compress images on the fly before every upload.
+
+namespace Compressor {
+
+    using Block = FirmwareUpdater::Component::CompressedBlock;
+
+    // Contiguous image data, sent in order
+    struct Segment
+    {
+        uint32_t address;
+        std::vector<uint8_t> data;
+    };
+
+    // Blocks never cross segments, and are limited to blockSize bytes of image data and
+    // payloadSize bytes of compressed data
+    auto compress(const std::vector<Segment>& segments,
+                  size_t blockSize, size_t payloadSize) -> std::vector<Block>;
+
+    // Reflected CRC-32 without inversion, as computed by the bootloader
+    auto checksum(uint32_t crc, const uint8_t* data, size_t length) -> uint32_t;
+}
@@ -22,21 +22,21 @@
 // ============================================================================================== //
 
 #include "base64.h"
+#include "firmwarearchiveprivate.h"
+#include "hexdecoder.h"
 
-#include <FirmwareUpdater/Core/firmwarearchive.h>
-
-#include <openssl/evp.h>
 #include <openssl/pem.h>
 
-#ifdef __WIN32__
-#define ZIP_EXTERN
-#endif
-
-#include <zip.h>
-
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 // ---------------------------------------------------------------------------------------------- //
 
@@ -44,29 +44,18 @@ using namespace FirmwareUpdater;
 
 // ---------------------------------------------------------------------------------------------- //
 
-using PkeyGuard = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
 using CtxGuard = std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>;
 
-using ZipGuard = std::unique_ptr<zip, decltype(&zip_close)>;
-
-using ByteArray = std::vector<uint8_t>;
-
 using Error = FirmwareArchive::Error;
 
 // ---------------------------------------------------------------------------------------------- //
 
 namespace FirmwareArchivePrivate {
 
-    auto openZipFile(const std::string& filename) -> zip*;
-    auto openZipData(const ByteArray& data) -> zip*;
+    struct HexChunk;
+    auto parseHexChunk(const char* begin, const char* end) -> HexChunk;
 
-    auto readFile(zip* handle, const std::string& filename) -> ByteArray;
-
-    auto base64Decode(const ByteArray& input) -> ByteArray;
-    void verifySignature(const ByteArray& data, const ByteArray& signature, const std::string& key);
-
-    auto parseMetadata(const ByteArray& data) -> FirmwareArchive::Metadata;
-    auto parseHexFile(const ByteArray& data) -> FirmwareArchive::StringList;
+    void throwHexError(const std::string& error, size_t lineNumber);
 
     auto trimString(const std::string& s) -> std::string;
     auto splitString(const std::string& s, char delim) -> std::vector<std::string>;
@@ -74,7 +63,28 @@ namespace FirmwareArchivePrivate {
 
 // ---------------------------------------------------------------------------------------------- //
 
-std::map<std::string,std::string> FirmwareArchive::s_publicKeys;
+namespace {
+    using PublicKey = std::shared_ptr<EVP_PKEY>;
+    using PublicKeyMap = std::map<std::string, PublicKey>;
+
+    // Keys are parsed once when registered. Readers take a snapshot of the map without locking,
+    // writers replace it with an updated copy, so a snapshot stays valid while it's being used.
+    std::atomic<std::shared_ptr<const PublicKeyMap>> g_publicKeys;
+    std::mutex g_publicKeysMutex; // Serializes writers only
+
+    std::atomic<uint64_t> g_publicKeyGeneration = 0;
+
+    auto findPublicKey(const std::string& packager) -> PublicKey
+    {
+        const std::shared_ptr<const PublicKeyMap> keys = g_publicKeys.load();
+
+        if (!keys)
+            return nullptr;
+
+        auto it = keys->find(packager);
+        return (it != keys->end()) ? it->second : nullptr;
+    }
+}
 
 // ---------------------------------------------------------------------------------------------- //
 
@@ -94,18 +104,21 @@ FirmwareArchive::FirmwareArchive(const std::string& filename)
     const ByteArray metadata = readFile(dataHandle, "METADATA");
     m_metadata = parseMetadata(metadata);
 
-    auto it = s_publicKeys.find(m_metadata.packager);
+    const PublicKey key = findPublicKey(m_metadata.packager);
 
-    if (it == s_publicKeys.end())
+    if (!key)
     {
         throw Error("Unable to verify package signature. No RSA public key "
                     "registered for packager " + m_metadata.packager + ".");
     }
 
-    verifySignature(dataFile, base64Decode(signature), it->second);
+    verifySignature(dataFile, base64Decode(signature), key.get());
 
     const ByteArray hexFile = readFile(dataHandle, "Data.hex");
-    m_hexRecords = parseHexFile(hexFile);
+    m_hexRecords = parseHexFile(hexFile, &m_dataRecords);
+
+    if (containsFile(dataHandle, "Data.delta"))
+        m_delta = parseDelta(readFile(dataHandle, "Data.delta"));
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -124,6 +137,20 @@ auto FirmwareArchive::hexRecords() const -> const StringList&
 
 // ---------------------------------------------------------------------------------------------- //
 
+auto FirmwareArchive::dataRecords() const -> const DataRecordList&
+{
+    return m_dataRecords;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto FirmwareArchive::delta() const -> const std::optional<Delta>&
+{
+    return m_delta;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void FirmwareArchive::registerPublicKey(const std::string& packager, const std::string& key)
 {
     const bool keyValid = key.starts_with("-----BEGIN RSA PUBLIC KEY-----\n") &&
@@ -131,7 +158,43 @@ void FirmwareArchive::registerPublicKey(const std::string& packager, const std::
     if (!keyValid)
         throw Error("RSA key not in valid PEM format.");
 
-    s_publicKeys[packager] = key;
+    PublicKey pkey = FirmwareArchivePrivate::parsePublicKey(key);
+
+    std::lock_guard lock(g_publicKeysMutex);
+
+    const std::shared_ptr<const PublicKeyMap> keys = g_publicKeys.load();
+    auto newKeys = keys ? std::make_shared<PublicKeyMap>(*keys) : std::make_shared<PublicKeyMap>();
+
+    (*newKeys)[packager] = std::move(pkey);
+    g_publicKeys.store(std::move(newKeys));
+
+    ++g_publicKeyGeneration;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareArchive::unregisterPublicKey(const std::string& packager)
+{
+    std::lock_guard lock(g_publicKeysMutex);
+
+    const std::shared_ptr<const PublicKeyMap> keys = g_publicKeys.load();
+
+    if (!keys || !keys->contains(packager))
+        return;
+
+    auto newKeys = std::make_shared<PublicKeyMap>(*keys);
+
+    newKeys->erase(packager);
+    g_publicKeys.store(std::move(newKeys));
+
+    ++g_publicKeyGeneration;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto FirmwareArchive::publicKeyGeneration() -> uint64_t
+{
+    return g_publicKeyGeneration.load();
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -201,6 +264,13 @@ auto FirmwareArchivePrivate::readFile(zip* handle, const std::string& filename)
 
 // ---------------------------------------------------------------------------------------------- //
 
+auto FirmwareArchivePrivate::containsFile(zip* handle, const std::string& filename) -> bool
+{
+    return zip_name_locate(handle, filename.c_str(), 0) >= 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 auto FirmwareArchivePrivate::base64Decode(const ByteArray& input) -> ByteArray
 {
     ByteArray result(BASE64_DECODE_RESULT_SIZE(input.size()));
@@ -219,8 +289,7 @@ auto FirmwareArchivePrivate::base64Decode(const ByteArray& input) -> ByteArray
 
 // ---------------------------------------------------------------------------------------------- //
 
-void FirmwareArchivePrivate::verifySignature(const ByteArray& data, const ByteArray& signature,
-                                             const std::string& key)
+auto FirmwareArchivePrivate::parsePublicKey(const std::string& key) -> PkeyGuard
 {
     BIO* bio = BIO_new_mem_buf(key.data(), static_cast<int>(key.size()));
     EVP_PKEY* pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
@@ -230,12 +299,18 @@ void FirmwareArchivePrivate::verifySignature(const ByteArray& data, const ByteAr
     if (!pkey)
         throw Error("Unable to parse RSA public key.");
 
-    EVP_MD_CTX* ctx = EVP_MD_CTX_create();
+    return PkeyGuard(pkey, EVP_PKEY_free);
+}
+
+// ---------------------------------------------------------------------------------------------- //
 
-    PkeyGuard pkeyGuard(pkey, EVP_PKEY_free);
+void FirmwareArchivePrivate::verifySignature(const ByteArray& data, const ByteArray& signature,
+                                             EVP_PKEY* key)
+{
+    EVP_MD_CTX* ctx = EVP_MD_CTX_create();
     CtxGuard ctxGuard(ctx, EVP_MD_CTX_free);
 
-    if (EVP_DigestVerifyInit(ctx, nullptr, EVP_sha256(), nullptr, pkey) <= 0)
+    if (EVP_DigestVerifyInit(ctx, nullptr, EVP_sha256(), nullptr, key) <= 0)
         throw Error("Unable to initialize OpenSSL digest verification.");
 
     const int result = EVP_DigestVerify(ctx, signature.data(), signature.size(),
@@ -301,36 +376,292 @@ auto FirmwareArchivePrivate::parseMetadata(const ByteArray& data) -> FirmwareArc
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto FirmwareArchivePrivate::parseHexFile(const ByteArray& data) -> FirmwareArchive::StringList
+namespace FirmwareArchivePrivate {
+
+    enum RecordType : uint8_t
+    {
+        Data                   = 0,
+        EndOfFile              = 1,
+        ExtendedSegmentAddress = 2,
+        StartSegmentAddress    = 3,
+        ExtendedLinearAddress  = 4,
+        StartLinearAddress     = 5
+    };
+
+    struct HexRecord
+    {
+        size_t lineNumber; // Relative to start of chunk
+        uint8_t type;
+        uint8_t length;
+        uint32_t address; // Offset, or upper address bits for extended linear address records
+        std::string text;
+    };
+
+    struct HexChunk
+    {
+        std::vector<HexRecord> records;
+        size_t lineCount = 0;
+
+        const char* error = nullptr; // Parsing stops at the first error
+        size_t errorLine = 0;
+    };
+
+    // Files larger than this are split on line boundaries and parsed concurrently
+    constexpr size_t ParallelThreshold = 1024 * 1024;
+    constexpr size_t MinimumChunkSize = 256 * 1024;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto FirmwareArchivePrivate::parseHexFile(const ByteArray& data,
+                                          FirmwareArchive::DataRecordList* dataRecords)
+    -> FirmwareArchive::StringList
 {
+    const char* begin = reinterpret_cast<const char*>(data.data());
+    const char* end = begin + data.size();
+
+    std::vector<HexChunk> chunks;
+
+    const size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunkCount = std::min(threadCount, data.size() / MinimumChunkSize);
+
+    if (data.size() < ParallelThreshold || chunkCount < 2)
+        chunks.push_back(parseHexChunk(begin, end));
+    else
+    {
+        std::vector<std::future<HexChunk>> futures;
+
+        const char* chunkBegin = begin;
+
+        for (size_t i = 1; i <= chunkCount && chunkBegin < end; ++i)
+        {
+            const char* chunkEnd = end;
+
+            if (i < chunkCount)
+            {
+                const size_t offset = data.size() * i / chunkCount;
+                const char* lineEnd = static_cast<const char*>(
+                            std::memchr(begin + offset, '\n', data.size() - offset));
+
+                chunkEnd = lineEnd ? std::max(lineEnd + 1, chunkBegin) : end;
+            }
+
+            futures.push_back(std::async(std::launch::async, parseHexChunk, chunkBegin, chunkEnd));
+            chunkBegin = chunkEnd;
+        }
+
+        for (auto& future : futures)
+            chunks.push_back(future.get());
+    }
+
+    // Addresses and record order depend on preceding records, so resolve them sequentially
     FirmwareArchive::StringList hexRecords;
 
-    std::string string(data.begin(), data.end());
-    std::istringstream stream(string);
+    size_t lineOffset = 0;
+    uint32_t baseAddress = 0;
+    bool endOfFile = false;
 
-    size_t lineNumber = 0;
+    for (HexChunk& chunk : chunks)
+    {
+        for (HexRecord& record : chunk.records)
+        {
+            const size_t lineNumber = lineOffset + record.lineNumber;
 
-    std::string line;
-    while (std::getline(stream, line))
+            if (endOfFile)
+                throwHexError("Record after end of file", lineNumber);
+
+            switch (record.type)
+            {
+            case Data:
+                if (dataRecords)
+                    dataRecords->push_back({ lineNumber, baseAddress + record.address,
+                                             record.length });
+                break;
+
+            case EndOfFile:
+                endOfFile = true;
+                break;
+
+            case ExtendedLinearAddress:
+                baseAddress = record.address;
+                break;
+
+            default:
+                break;
+            }
+
+            hexRecords.push_back(std::move(record.text));
+        }
+
+        if (chunk.error)
+            throwHexError(chunk.error, lineOffset + chunk.errorLine);
+
+        lineOffset += chunk.lineCount;
+    }
+
+    if (!endOfFile)
+        throw Error("Missing end-of-file record in firmware data.");
+
+    return hexRecords;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto FirmwareArchivePrivate::parseHexChunk(const char* begin, const char* end) -> HexChunk
+{
+    // Record layout: ':' LL AAAA TT DD... CC
+    static constexpr size_t MinimumLength = 11;
+    static constexpr size_t MaximumByteCount = 5 + 255;
+
+    HexChunk chunk;
+
+    const auto fail = [&](const char* error) {
+        chunk.error = error;
+        chunk.errorLine = chunk.lineCount;
+        return std::move(chunk);
+    };
+
+    std::array<uint8_t, MaximumByteCount> bytes;
+
+    const char* lineBegin = begin;
+
+    while (lineBegin < end)
     {
-        ++lineNumber;
+        const auto* newline = static_cast<const char*>(std::memchr(lineBegin, '\n',
+                                                                   end - lineBegin));
+        const char* lineEnd = newline ? newline : end;
+        const char* next = newline ? newline + 1 : end;
+
+        ++chunk.lineCount;
 
-        std::erase(line, '\r');
-        std::erase(line, '\n');
+        while (lineEnd > lineBegin && lineEnd[-1] == '\r')
+            --lineEnd;
 
-        if (line.empty())
+        const auto length = static_cast<size_t>(lineEnd - lineBegin);
+
+        if (length == 0)
+        {
+            lineBegin = next;
             continue;
+        }
+
+        if (lineBegin[0] != ':' || length < MinimumLength || length % 2 == 0)
+            return fail("Invalid record");
+
+        const size_t byteCount = (length - 1) / 2;
+
+        if (byteCount > MaximumByteCount)
+            return fail("Invalid length");
+
+        uint8_t checksum = 0;
 
-        if (line.front() != ':')
+        if (!HexDecoder::decode(lineBegin + 1, byteCount, bytes.data(), &checksum))
+            return fail("Invalid character");
+
+        const uint8_t dataLength = bytes[0];
+        const uint16_t address = (bytes[1] << 8) | bytes[2];
+        const uint8_t type = bytes[3];
+
+        if (byteCount != dataLength + 5u)
+            return fail("Invalid length");
+
+        if (checksum != 0)
+            return fail("Invalid checksum");
+
+        HexRecord record = { chunk.lineCount, type, dataLength, address,
+                             std::string(lineBegin, lineEnd) };
+
+        switch (type)
         {
-            throw Error("Invalid record in firmware data on line "
-                            + std::to_string(lineNumber) + ".");
+        case Data:
+        case EndOfFile:
+        case StartSegmentAddress:
+        case StartLinearAddress:
+            break;
+
+        case ExtendedLinearAddress:
+            if (dataLength != 2)
+                return fail("Invalid length");
+
+            record.address = (bytes[4] << 24) | (bytes[5] << 16);
+            break;
+
+        default: // Segment addressing isn't supported by the bootloader
+            return fail("Unsupported record type");
         }
 
-        hexRecords.push_back(std::move(line));
+        chunk.records.push_back(std::move(record));
+        lineBegin = next;
     }
 
-    return hexRecords;
+    return chunk;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Operations are checked against the lengths in the header, whether the result matches the
+// hex file is checked before uploading
+auto FirmwareArchivePrivate::parseDelta(const ByteArray& data) -> FirmwareArchive::Delta
+{
+    static constexpr size_t HeaderSize = 16;
+    static constexpr uint8_t CopyCode = 0x80;
+    static constexpr size_t CopySize = 7;
+
+    if (data.size() < HeaderSize)
+        throw Error("Invalid header in firmware delta.");
+
+    const auto read = [&](size_t offset, size_t count) {
+        uint32_t value = 0;
+
+        for (size_t i = 0; i < count; ++i)
+            value |= static_cast<uint32_t>(data[offset + i]) << (i*8);
+
+        return value;
+    };
+
+    FirmwareArchive::Delta delta = { read(0, 4), read(4, 4), read(8, 4), read(12, 4),
+                                     ByteArray(data.begin() + HeaderSize, data.end()) };
+    uint64_t length = 0;
+
+    for (size_t i = HeaderSize; i < data.size(); )
+    {
+        if (data[i] == CopyCode)
+        {
+            if (data.size() - i < CopySize)
+                throw Error("Incomplete operation in firmware delta.");
+
+            const uint64_t source = read(i + 1, 4);
+            const uint64_t count = read(i + 5, 2);
+
+            if (source + count > delta.sourceLength)
+                throw Error("Copy outside of base image in firmware delta.");
+
+            length += count;
+            i += CopySize;
+        }
+        else
+        {
+            const size_t count = data[i];
+
+            if (count == 0 || data.size() - i <= count)
+                throw Error("Incomplete operation in firmware delta.");
+
+            length += count;
+            i += count + 1;
+        }
+    }
+
+    if (length != delta.targetLength)
+        throw Error("Length of firmware delta doesn't match its header.");
+
+    return delta;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareArchivePrivate::throwHexError(const std::string& error, size_t lineNumber)
+{
+    throw Error(error + " in firmware data on line " + std::to_string(lineNumber) + ".");
 }
 
 // ---------------------------------------------------------------------------------------------- //
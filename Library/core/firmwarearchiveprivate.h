@@ -0,0 +1,69 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <FirmwareUpdater/Core/firmwarearchive.h>
+
+#include <openssl/evp.h>
+
+#ifdef __WIN32__
+#define ZIP_EXTERN
+#endif
+
+#include <zip.h>
+
+#include <memory>
+
+// Internal stages of loading a firmware archive. Not part of the public interface, but exposed
+// here so that they can be benchmarked individually.
+
+using PkeyGuard = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+using ZipGuard = std::unique_ptr<zip, decltype(&zip_close)>;
+
+using ByteArray = std::vector<uint8_t>;
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace FirmwareArchivePrivate {
+
+    auto openZipFile(const std::string& filename) -> zip*;
+    auto openZipData(const ByteArray& data) -> zip*;
+
+    auto readFile(zip* handle, const std::string& filename) -> ByteArray;
+    auto containsFile(zip* handle, const std::string& filename) -> bool;
+
+    auto base64Decode(const ByteArray& input) -> ByteArray;
+
+    auto parsePublicKey(const std::string& key) -> PkeyGuard;
+    void verifySignature(const ByteArray& data, const ByteArray& signature, EVP_PKEY* key);
+
+    auto parseMetadata(const ByteArray& data) -> FirmwareUpdater::FirmwareArchive::Metadata;
+    auto parseHexFile(const ByteArray& data,
+                      FirmwareUpdater::FirmwareArchive::DataRecordList* dataRecords)
+        -> FirmwareUpdater::FirmwareArchive::StringList;
+
+    auto parseDelta(const ByteArray& data) -> FirmwareUpdater::FirmwareArchive::Delta;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -24,6 +24,8 @@
 #include <FirmwareUpdater/Core/firmwaremanager.h>
 
 #include <filesystem>
+#include <map>
+#include <mutex>
 #include <regex>
 
 // ---------------------------------------------------------------------------------------------- //
@@ -34,6 +36,64 @@ using namespace FirmwareUpdater;
 
 namespace {
     constexpr const char* RepositoryDirectory = "repository/";
+
+    // Archives currently in use, so that concurrent jobs share a single loaded instance. Entries
+    // are only valid for the file they were loaded from and the public keys they were verified
+    // with.
+    struct CacheEntry
+    {
+        std::filesystem::file_time_type lastWriteTime;
+        uint64_t keyGeneration = 0;
+        std::weak_ptr<const FirmwareArchive> archive;
+
+        auto matches(std::filesystem::file_time_type time, uint64_t generation) const -> bool
+        {
+            return lastWriteTime == time && keyGeneration == generation;
+        }
+    };
+
+    std::map<std::string, CacheEntry> g_archiveCache;
+    std::mutex g_archiveCacheMutex;
+
+    auto findCachedArchive(const std::string& filename,
+                           std::filesystem::file_time_type lastWriteTime,
+                           uint64_t keyGeneration) -> FirmwareArchivePtr
+    {
+        std::lock_guard lock(g_archiveCacheMutex);
+
+        auto it = g_archiveCache.find(filename);
+
+        if (it == g_archiveCache.end() || !it->second.matches(lastWriteTime, keyGeneration))
+            return nullptr;
+
+        return it->second.archive.lock();
+    }
+
+    // Returns the archive cached by another job in the meantime, if any, so that the jobs still
+    // end up sharing a single instance
+    auto cacheArchive(const std::string& filename, std::filesystem::file_time_type lastWriteTime,
+                      uint64_t keyGeneration, FirmwareArchivePtr archive) -> FirmwareArchivePtr
+    {
+        std::lock_guard lock(g_archiveCacheMutex);
+
+        std::erase_if(g_archiveCache, [](const auto& item) {
+            return item.second.archive.expired();
+        });
+
+        CacheEntry& entry = g_archiveCache[filename];
+
+        if (entry.matches(lastWriteTime, keyGeneration))
+        {
+            if (FirmwareArchivePtr cached = entry.archive.lock())
+                return cached;
+        }
+
+        entry.lastWriteTime = lastWriteTime;
+        entry.keyGeneration = keyGeneration;
+        entry.archive = archive;
+
+        return archive;
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -72,18 +132,29 @@ auto FirmwareManager::getAvailableVersion(const std::string& boardName,
 // ---------------------------------------------------------------------------------------------- //
 
 auto FirmwareManager::loadArchive(const std::string& boardName,
-                                  const std::string& hardwareVersion) -> FirmwareArchive
+                                  const std::string& hardwareVersion) -> FirmwareArchivePtr
 {
     const std::string firmwareVersion = getAvailableVersion(boardName, hardwareVersion);
 
     if (firmwareVersion.empty())
         throw Error("No firmware version is available for the given name.");
 
-    const FirmwareArchive archive(RepositoryDirectory + boardName + "-"
-                                                      + hardwareVersion + "-"
-                                                      + firmwareVersion + ".zip");
+    const std::string filename = RepositoryDirectory + boardName + "-"
+                                                    + hardwareVersion + "-"
+                                                    + firmwareVersion + ".zip";
+
+    const auto lastWriteTime = std::filesystem::last_write_time(filename);
+
+    // Read before loading, so that a key changed while loading causes the next job to reload
+    const uint64_t keyGeneration = FirmwareArchive::publicKeyGeneration();
+
+    if (FirmwareArchivePtr archive = findCachedArchive(filename, lastWriteTime, keyGeneration))
+        return archive;
+
+    // Loading isn't done under the lock, so that unrelated archives can be loaded in parallel
+    FirmwareArchivePtr archive = std::make_shared<const FirmwareArchive>(filename);
 
-    const FirmwareArchive::Metadata& metadata = archive.metadata();
+    const FirmwareArchive::Metadata& metadata = archive->metadata();
 
     if (metadata.boardName != boardName)
     {
@@ -103,7 +174,7 @@ auto FirmwareManager::loadArchive(const std::string& boardName,
                     "match the version specified by the file name.");
     }
 
-    return archive;
+    return cacheArchive(filename, lastWriteTime, keyGeneration, std::move(archive));
 }
 
 // ---------------------------------------------------------------------------------------------- //
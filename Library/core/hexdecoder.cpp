@@ -0,0 +1,291 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "hexdecoder.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEXDECODER_X86
+#include <immintrin.h>
+#endif
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    using DecodeFunction = bool(*)(const char*, size_t, uint8_t*, uint8_t*);
+
+    constexpr auto makeNibbleTable()
+    {
+        struct { int8_t values[256]; } table = {};
+
+        for (int c = 0; c < 256; ++c)
+        {
+            if (c >= '0' && c <= '9')
+                table.values[c] = static_cast<int8_t>(c - '0');
+            else if (c >= 'A' && c <= 'F')
+                table.values[c] = static_cast<int8_t>(c - 'A' + 10);
+            else if (c >= 'a' && c <= 'f')
+                table.values[c] = static_cast<int8_t>(c - 'a' + 10);
+            else
+                table.values[c] = -1;
+        }
+
+        return table;
+    }
+
+    constexpr auto NibbleTable = makeNibbleTable();
+
+    // ------------------------------------------------------------------------------------------ //
+
+    auto decodeScalar(const char* hex, size_t count, uint8_t* output, uint8_t* checksum) -> bool
+    {
+        uint8_t sum = *checksum;
+        int invalid = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const int high = NibbleTable.values[static_cast<uint8_t>(hex[2*i])];
+            const int low = NibbleTable.values[static_cast<uint8_t>(hex[2*i + 1])];
+
+            invalid |= high | low; // Negative if either is invalid
+
+            const auto byte = static_cast<uint8_t>((high << 4) | (low & 0x0f));
+            output[i] = byte;
+            sum += byte;
+        }
+
+        *checksum = sum;
+        return invalid >= 0;
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+#ifdef HEXDECODER_X86
+    // Maps 16 hex characters to nibble values. Invalid characters are flagged in 'error'.
+    __attribute__((target("sse2")))
+    inline auto nibblesSSE2(__m128i chars, __m128i& error) -> __m128i
+    {
+        const __m128i digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+        const __m128i letters = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)),
+                                             _mm_set1_epi8('a'));
+
+        // Unsigned x <= n is equivalent to min(x, n) == x
+        const __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+        const __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letters, _mm_set1_epi8(5)), letters);
+
+        error = _mm_or_si128(error, _mm_andnot_si128(_mm_or_si128(isDigit, isLetter),
+                                                     _mm_set1_epi8(-1)));
+
+        const __m128i letterValues = _mm_add_epi8(letters, _mm_set1_epi8(10));
+
+        return _mm_or_si128(_mm_and_si128(isDigit, digits),
+                            _mm_andnot_si128(isDigit, letterValues));
+    }
+
+    // Combines pairs of nibbles into bytes, yielding eight bytes in 16-bit lanes
+    __attribute__((target("sse2")))
+    inline auto combineSSE2(__m128i nibbles) -> __m128i
+    {
+        const __m128i high = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4);
+        const __m128i low = _mm_srli_epi16(nibbles, 8);
+
+        return _mm_or_si128(high, low);
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    __attribute__((target("sse2")))
+    auto decodeSSE2(const char* hex, size_t count, uint8_t* output, uint8_t* checksum) -> bool
+    {
+        __m128i error = _mm_setzero_si128();
+        __m128i sum = _mm_setzero_si128();
+
+        size_t i = 0;
+
+        for (; i + 16 <= count; i += 16)
+        {
+            const auto* input = reinterpret_cast<const __m128i*>(hex + 2*i);
+
+            const __m128i first = combineSSE2(nibblesSSE2(_mm_loadu_si128(input), error));
+            const __m128i second = combineSSE2(nibblesSSE2(_mm_loadu_si128(input + 1), error));
+
+            const __m128i bytes = _mm_packus_epi16(first, second);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), bytes);
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(bytes, _mm_setzero_si128()));
+        }
+
+        alignas(16) uint64_t partial[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(partial), sum);
+
+        *checksum += static_cast<uint8_t>(partial[0] + partial[1]);
+
+        const bool valid = _mm_movemask_epi8(error) == 0;
+
+        return decodeScalar(hex + 2*i, count - i, output + i, checksum) && valid;
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    __attribute__((target("avx2")))
+    inline auto nibblesAVX2(__m256i chars, __m256i& error) -> __m256i
+    {
+        const __m256i digits = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+        const __m256i letters = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)),
+                                                _mm256_set1_epi8('a'));
+
+        const __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digits, _mm256_set1_epi8(9)),
+                                                  digits);
+        const __m256i isLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(letters, _mm256_set1_epi8(5)),
+                                                   letters);
+
+        error = _mm256_or_si256(error, _mm256_andnot_si256(_mm256_or_si256(isDigit, isLetter),
+                                                           _mm256_set1_epi8(-1)));
+
+        const __m256i letterValues = _mm256_add_epi8(letters, _mm256_set1_epi8(10));
+
+        return _mm256_blendv_epi8(letterValues, digits, isDigit);
+    }
+
+    __attribute__((target("avx2")))
+    inline auto combineAVX2(__m256i nibbles) -> __m256i
+    {
+        const __m256i high = _mm256_slli_epi16(_mm256_and_si256(nibbles,
+                                                                _mm256_set1_epi16(0x00ff)), 4);
+        const __m256i low = _mm256_srli_epi16(nibbles, 8);
+
+        return _mm256_or_si256(high, low);
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    __attribute__((target("avx2")))
+    auto decodeAVX2(const char* hex, size_t count, uint8_t* output, uint8_t* checksum) -> bool
+    {
+        __m256i error = _mm256_setzero_si256();
+        __m256i sum = _mm256_setzero_si256();
+
+        size_t i = 0;
+
+        for (; i + 32 <= count; i += 32)
+        {
+            const auto* input = reinterpret_cast<const __m256i*>(hex + 2*i);
+
+            const __m256i first = combineAVX2(nibblesAVX2(_mm256_loadu_si256(input), error));
+            const __m256i second = combineAVX2(nibblesAVX2(_mm256_loadu_si256(input + 1), error));
+
+            // Packing operates on 128-bit lanes, so restore the order of the 64-bit blocks
+            const __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second),
+                                                           _MM_SHUFFLE(3, 1, 2, 0));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), bytes);
+            sum = _mm256_add_epi64(sum, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+        }
+
+        alignas(32) uint64_t partial[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(partial), sum);
+
+        *checksum += static_cast<uint8_t>(partial[0] + partial[1] + partial[2] + partial[3]);
+
+        const bool valid = _mm256_movemask_epi8(error) == 0;
+
+        return decodeSSE2(hex + 2*i, count - i, output + i, checksum) && valid;
+    }
+#endif // HEXDECODER_X86
+
+    // ------------------------------------------------------------------------------------------ //
+
+    auto getFunction(HexDecoder::Implementation implementation) -> DecodeFunction
+    {
+        switch (implementation)
+        {
+#ifdef HEXDECODER_X86
+        case HexDecoder::Implementation::AVX2:
+            return decodeAVX2;
+
+        case HexDecoder::Implementation::SSE2:
+            return decodeSSE2;
+#endif
+        default:
+            return decodeScalar;
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------ //
+
+    const DecodeFunction BestFunction = getFunction(HexDecoder::bestImplementation());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HexDecoder::bestImplementation() -> Implementation
+{
+    if (isSupported(Implementation::AVX2))
+        return Implementation::AVX2;
+
+    if (isSupported(Implementation::SSE2))
+        return Implementation::SSE2;
+
+    return Implementation::Scalar;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HexDecoder::isSupported(Implementation implementation) -> bool
+{
+#ifdef HEXDECODER_X86
+    __builtin_cpu_init(); // May be called during static initialization
+#endif
+
+    switch (implementation)
+    {
+#ifdef HEXDECODER_X86
+    case Implementation::AVX2:
+        return __builtin_cpu_supports("avx2");
+
+    case Implementation::SSE2:
+        return __builtin_cpu_supports("sse2");
+#endif
+    case Implementation::Scalar:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HexDecoder::decode(const char* hex, size_t count, uint8_t* output, uint8_t* checksum) -> bool
+{
+    return BestFunction(hex, count, output, checksum);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HexDecoder::decode(const char* hex, size_t count, uint8_t* output, uint8_t* checksum,
+                        Implementation implementation) -> bool
+{
+    return getFunction(implementation)(hex, count, output, checksum);
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,50 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Converts ASCII hex digits to binary. Uses SSE2 or AVX2 where available and falls back to a
+// scalar implementation otherwise. The checksum is the 8-bit sum of all decoded bytes, which
+// is zero for a valid Intel HEX record.
+
+namespace HexDecoder {
+
+    enum class Implementation
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    auto bestImplementation() -> Implementation;
+    auto isSupported(Implementation implementation) -> bool;
+
+    // Decodes 2*count characters into count bytes, returns false on invalid characters
+    auto decode(const char* hex, size_t count, uint8_t* output, uint8_t* checksum) -> bool;
+
+    auto decode(const char* hex, size_t count, uint8_t* output, uint8_t* checksum,
+                Implementation implementation) -> bool;
+}
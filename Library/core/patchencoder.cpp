@@ -0,0 +1,227 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "compressor.h"
+#include "patchencoder.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr uint8_t CopyCode = 0x80;
+    constexpr size_t CopySize = 7;
+    constexpr size_t HeaderSize = 16;
+
+    constexpr size_t MaximumCopyLength = 0xffff;
+    constexpr size_t MaximumInsertLength = 127;
+
+    struct Operation
+    {
+        bool copy;
+        uint32_t source; // Only used by copies, literal data is taken from the image
+        uint32_t length;
+    };
+
+    auto readLittleEndian(const uint8_t* bytes, size_t count) -> uint32_t
+    {
+        uint32_t value = 0;
+
+        for (size_t i = 0; i < count; ++i)
+            value |= static_cast<uint32_t>(bytes[i]) << (i*8);
+
+        return value;
+    }
+
+    void appendLittleEndian(std::vector<uint8_t>* bytes, uint32_t value, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            bytes->push_back(static_cast<uint8_t>(value >> (i*8)));
+    }
+
+    // Merges with the previous operation where possible, so splitting at sector boundaries
+    // doesn't cost anything unless a copy actually has to be replaced
+    void append(std::vector<Operation>* operations, const Operation& operation)
+    {
+        if (!operations->empty())
+        {
+            Operation& last = operations->back();
+
+            const bool contiguous = !operation.copy ||
+                                    last.source + last.length == operation.source;
+
+            if (last.copy == operation.copy && contiguous)
+            {
+                last.length += operation.length;
+                return;
+            }
+        }
+
+        operations->push_back(operation);
+    }
+
+    class SectorMap
+    {
+    public:
+        SectorMap(const std::vector<size_t>& sizes)
+        {
+            size_t end = 0;
+
+            for (size_t size : sizes)
+                m_ends.push_back(end += size);
+        }
+
+        // Offsets beyond the partition are mapped to its last sector, the device rejects them
+        auto sectorOf(size_t offset) const -> size_t
+        {
+            const auto it = std::upper_bound(m_ends.begin(), m_ends.end(), offset);
+            return std::min<size_t>(it - m_ends.begin(), m_ends.size() - 1);
+        }
+
+        auto sectorEnd(size_t sector) const -> size_t
+        {
+            return (sector + 1 < m_ends.size()) ? m_ends[sector] : SIZE_MAX;
+        }
+
+    private:
+        std::vector<size_t> m_ends;
+    };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PatchEncoder::encode(const Delta& delta, const std::vector<uint8_t>& image,
+                          const std::vector<size_t>& sectorSizes,
+                          size_t payloadSize) -> std::vector<Block>
+{
+    if (image.size() != delta.targetLength || sectorSizes.empty() || payloadSize <= CopySize)
+        throw std::invalid_argument("Delta doesn't match image or device.");
+
+    const SectorMap sectors(sectorSizes);
+
+    // Copies are split wherever source or target enter a new sector, and the parts reading from
+    // a sector before the one being written are turned into literals
+    std::vector<Operation> operations;
+    uint32_t position = 0;
+
+    const std::vector<uint8_t>& input = delta.operations;
+
+    for (size_t i = 0; i < input.size(); )
+    {
+        if (input[i] != CopyCode)
+        {
+            append(&operations, { false, 0, input[i] });
+
+            position += input[i];
+            i += input[i] + 1;
+            continue;
+        }
+
+        uint32_t source = readLittleEndian(&input[i + 1], 4);
+        uint32_t length = readLittleEndian(&input[i + 5], 2);
+
+        while (length > 0)
+        {
+            const size_t targetSector = sectors.sectorOf(position);
+            const size_t sourceSector = sectors.sectorOf(source);
+
+            const size_t count = std::min({ static_cast<size_t>(length),
+                                             sectors.sectorEnd(targetSector) - position,
+                                             sectors.sectorEnd(sourceSector) - source });
+
+            const bool overwritten = (sourceSector < targetSector);
+            append(&operations, { !overwritten, source, static_cast<uint32_t>(count) });
+
+            position += count;
+            source += count;
+            length -= count;
+        }
+
+        i += CopySize;
+    }
+
+    std::vector<Block> blocks;
+    position = 0;
+
+    const auto available = [&] {
+        return payloadSize - blocks.back().operations.size();
+    };
+
+    const auto startBlock = [&] {
+        blocks.push_back({ position, 0, {} });
+    };
+
+    for (Operation operation : operations)
+    {
+        while (operation.length > 0)
+        {
+            if (blocks.empty())
+                startBlock();
+
+            if (operation.copy)
+            {
+                if (available() < CopySize)
+                    startBlock();
+
+                const uint32_t count = std::min<uint32_t>(operation.length, MaximumCopyLength);
+
+                std::vector<uint8_t>& data = blocks.back().operations;
+                data.push_back(CopyCode);
+                appendLittleEndian(&data, operation.source, 4);
+                appendLittleEndian(&data, count, 2);
+
+                operation.source += count;
+                operation.length -= count;
+                position += count;
+                continue;
+            }
+
+            if (available() < 2)
+                startBlock();
+
+            const size_t count = std::min({ static_cast<size_t>(operation.length),
+                                             MaximumInsertLength, available() - 1 });
+
+            std::vector<uint8_t>& data = blocks.back().operations;
+            data.push_back(static_cast<uint8_t>(count));
+            data.insert(data.end(), image.begin() + position, image.begin() + position + count);
+
+            operation.length -= count;
+            position += count;
+        }
+    }
+
+    for (Block& block : blocks)
+    {
+        std::vector<uint8_t> offset;
+        appendLittleEndian(&offset, block.offset, 4);
+
+        const uint32_t crc = Compressor::checksum(0, offset.data(), offset.size());
+        block.crc = Compressor::checksum(crc, block.operations.data(), block.operations.size());
+    }
+
+    return blocks;
+}
+
+// ---------------------------------------------------------------------------------------------- //
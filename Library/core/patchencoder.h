@@ -0,0 +1,46 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <FirmwareUpdater/Core/component.h>
+#include <FirmwareUpdater/Core/firmwarearchive.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Prepares a delta update for a particular device. The bootloader rewrites its firmware
+// partition sector by sector and only keeps a copy of the sector being written, so copies from
+// sectors already overwritten are replaced by the corresponding data of the firmware image.
+
+namespace PatchEncoder {
+
+    using Block = FirmwareUpdater::Component::PatchBlock;
+    using Delta = FirmwareUpdater::FirmwareArchive::Delta;
+
+    // The image is the target of the delta, the sector sizes those of the firmware partition.
+    // Blocks are limited to payloadSize bytes of operations.
+    auto encode(const Delta& delta, const std::vector<uint8_t>& image,
+                const std::vector<size_t>& sectorSizes, size_t payloadSize) -> std::vector<Block>;
+}
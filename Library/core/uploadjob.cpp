@@ -24,6 +24,11 @@
 #include <FirmwareUpdater/Core/firmwaremanager.h>
 #include <FirmwareUpdater/Core/uploadjob.h>
 
+#include "compressor.h"
+#include "hexdecoder.h"
+#include "patchencoder.h"
+
+#include <algorithm>
 #include <cassert>
 
 // ---------------------------------------------------------------------------------------------- //
@@ -32,15 +37,131 @@ using namespace FirmwareUpdater;
 
 // ---------------------------------------------------------------------------------------------- //
 
-UploadJob::UploadJob(Component* component)
-    : m_component(component),
-      m_archive(loadArchive(component))
-{
-    assert(component != nullptr);
+namespace {
+    // Written after the compressed blocks, so the device finishes the image as usual
+    const std::string EndOfFileRecord = ":00000001FF";
+
+    // Start code, length, address, type and checksum of a hex record
+    constexpr size_t RecordStringOverhead = 11;
+
+    // Records were validated when loading the archive, so they only need to be decoded
+    auto makeSegments(const FirmwareArchive::StringList& records)
+        -> std::vector<Compressor::Segment>
+    {
+        std::vector<Compressor::Segment> segments;
+
+        uint32_t baseAddress = 0;
+        std::vector<uint8_t> bytes;
+
+        for (const std::string& record : records)
+        {
+            bytes.resize((record.size() - 1) / 2);
+
+            uint8_t checksum = 0;
+            HexDecoder::decode(record.data() + 1, bytes.size(), bytes.data(), &checksum);
+
+            const uint8_t type = bytes[3];
+
+            if (type == 0x04)
+                baseAddress = (bytes[4] << 24) | (bytes[5] << 16);
+
+            if (type != 0x00)
+                continue;
+
+            const uint32_t address = baseAddress | (bytes[1] << 8) | bytes[2];
+            const auto data = bytes.begin() + 4;
+            const auto dataEnd = data + bytes[0];
+
+            if (!segments.empty())
+            {
+                Compressor::Segment& last = segments.back();
+
+                if (last.address + last.data.size() == address)
+                {
+                    last.data.insert(last.data.end(), data, dataEnd);
+                    continue;
+                }
+            }
+
+            segments.push_back({ address, { data, dataEnd } });
+        }
+
+        return segments;
+    }
+
+    // The image as it's left in flash, from the start of the firmware partition up to the end
+    // of the last segment. Empty if it doesn't start at the partition.
+    auto makeImage(const std::vector<Compressor::Segment>& segments, uint32_t startAddress)
+        -> std::vector<uint8_t>
+    {
+        if (segments.empty() || segments.front().address != startAddress)
+            return {};
+
+        uint32_t endAddress = startAddress;
+
+        for (const Compressor::Segment& segment : segments)
+            endAddress = std::max<uint32_t>(endAddress, segment.address + segment.data.size());
+
+        std::vector<uint8_t> image(endAddress - startAddress, 0xff);
+
+        for (const Compressor::Segment& segment : segments)
+        {
+            std::copy(segment.data.begin(), segment.data.end(),
+                      image.begin() + (segment.address - startAddress));
+        }
+
+        return image;
+    }
+
+    // Firmware staging an update doesn't report bootloader info
+    auto getHardwareInfo(Component* component) -> std::pair<std::string, std::string>
+    {
+        if (component->getBootMode() == Component::BootMode::Firmware)
+        {
+            const Component::FirmwareInfo info = component->getFirmwareInfo();
+            return { info.boardName, info.hardwareVersion };
+        }
+
+        const Component::BootloaderInfo info = component->getBootloaderInfo();
+        return { info.boardName, info.hardwareVersion };
+    }
+
+    void checkMetadata(const FirmwareArchivePtr& archive,
+                       const std::string& boardName, const std::string& hardwareVersion)
+    {
+        if (!archive)
+            throw UploadJob::Error("No firmware archive specified.");
+
+        const FirmwareArchive::Metadata& metadata = archive->metadata();
+
+        if (metadata.boardName != boardName)
+        {
+            throw UploadJob::Error("Board name in firmware metadata doesn't match "
+                                   "target hardware.");
+        }
+
+        if (metadata.hardwareVersion != hardwareVersion)
+        {
+            throw UploadJob::Error("Hardware version in firmware metadata doesn't match "
+                                   "target hardware.");
+        }
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
+UploadJob::UploadJob(Component* component)
+    : m_component(checkComponent(component)),
+      m_archive(loadArchive(m_component)) {}
+
+// ---------------------------------------------------------------------------------------------- //
+
+UploadJob::UploadJob(Component* component, FirmwareArchivePtr archive)
+    : m_component(checkComponent(component)),
+      m_archive(checkArchive(m_component, std::move(archive))) {}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void UploadJob::run(const ProgressFunction& progress_, const MessageFunction& message_)
 {
     static const ProgressFunction dummyProgress = [](int,int,int) {};
@@ -49,23 +170,104 @@ void UploadJob::run(const ProgressFunction& progress_, const MessageFunction& me
     const auto progress = progress_ ? progress_ : dummyProgress;
     const auto message = message_ ? message_ : dummyMessage;
 
+    if (m_component->getBootMode() == Component::BootMode::Firmware)
+    {
+        const std::optional<Component::StagingInfo> staging = m_component->getStagingInfo();
+
+        if (!staging)
+            throw Error("Firmware doesn't stage updates, launch the bootloader first.");
+
+        stageFirmware(*staging, progress, message);
+        return;
+    }
+
     const Component::BootloaderInfo info = m_component->getBootloaderInfo();
 
+    // Records are only sent as they are if the device doesn't accept compressed blocks
+    const bool sendsRecords = (info.blockSize == 0 || info.blockPayloadSize == 0);
+
+    // Catch invalid images before the device is erased
+    checkRecords(info.firmwareStartAddress, info.firmwareEndAddress, info.wordSize,
+                 sendsRecords ? info.maximumRecordLength : 0);
+
+    message("Firmware image validated.");
+
     m_component->unlockFirmware();
-    message("Firmware unlocked, erasing now.");
 
-    for (size_t i = 0; i < info.sectorCount; ++i)
+    if (writePatch(info, progress, message))
     {
-        m_component->eraseSector(i);
+        m_component->lockFirmware();
+        message("Firmware update complete.");
+        return;
+    }
+
+    if (info.eraseOnWrite)
+    {
+        message("Firmware unlocked, sectors are erased as they are written.");
+        progress(100, 0, 0);
+    }
+    else
+    {
+        message("Firmware unlocked, erasing now.");
+        eraseSectors(info.sectorCount, progress, message);
+    }
+
+    if (sendsRecords)
+        writeRecords(info.eraseOnWrite, progress, message);
+    else
+        writeBlocks(info, progress, message);
+
+    m_component->lockFirmware();
+    message("Firmware upload complete.");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Unlocking, erasing and writing address the staging slot while the firmware is running
+void UploadJob::stageFirmware(const Component::StagingInfo& info,
+                              const ProgressFunction& progress, const MessageFunction& message)
+{
+    // The firmware doesn't report its partition, records outside of it are refused when written
+    checkRecords(0, 0, 0, info.maximumRecordLength);
+    message("Firmware image validated.");
+
+    m_component->unlockFirmware();
+
+    message("Staging slot unlocked, erasing now.");
+    eraseSectors(info.sectorCount, progress, message);
+
+    writeRecords(false, progress, message);
+    m_component->lockFirmware();
+
+    // The device keeps running its current firmware unless the staged image is complete
+    if (!m_component->getStagedFirmwareValid())
+        throw Error("Staged firmware image is invalid.");
 
-        message("Sector " + std::to_string(i+1) +
-                " of " + std::to_string(info.sectorCount) + " erased.");
+    message("Firmware image staged, installing now.");
+    m_component->installFirmware();
 
-        const int eraseProgress = (i+1) * 100 / info.sectorCount;
+    message("Firmware update complete.");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void UploadJob::eraseSectors(size_t count,
+                             const ProgressFunction& progress, const MessageFunction& message)
+{
+    m_component->eraseSectors(0, count, [&](size_t i) {
+        message("Sector " + std::to_string(i+1) + " of " + std::to_string(count) + " erased.");
+
+        const int eraseProgress = (i+1) * 100 / count;
         progress(eraseProgress, 0, eraseProgress/2);
-    }
+    });
+}
 
-    const FirmwareArchive::StringList& records = m_archive.hexRecords();
+// ---------------------------------------------------------------------------------------------- //
+
+void UploadJob::writeRecords(bool eraseOnWrite,
+                             const ProgressFunction& progress, const MessageFunction& message)
+{
+    const FirmwareArchive::StringList& records = m_archive->hexRecords();
 
     for (size_t i = 0; i < records.size(); ++i)
     {
@@ -77,31 +279,173 @@ void UploadJob::run(const ProgressFunction& progress_, const MessageFunction& me
                 " of " + std::to_string(records.size()) + " written.");
 
         const int uploadProgress = (i+1) * 100 / records.size();
-        progress(100, uploadProgress, 50 + uploadProgress/2);
+        const int totalProgress = eraseOnWrite ? uploadProgress : 50 + uploadProgress/2;
+        progress(100, uploadProgress, totalProgress);
     }
+}
 
-    m_component->lockFirmware();
-    message("Firmware upload complete.");
+// ---------------------------------------------------------------------------------------------- //
+
+void UploadJob::writeBlocks(const Component::BootloaderInfo& info,
+                            const ProgressFunction& progress, const MessageFunction& message)
+{
+    const std::vector<Compressor::Segment> segments = makeSegments(m_archive->hexRecords());
+    const std::vector<Compressor::Block> blocks = Compressor::compress(segments, info.blockSize,
+                                                                       info.blockPayloadSize);
+    size_t imageSize = 0;
+    size_t compressedSize = 0;
+
+    for (const Compressor::Block& block : blocks)
+    {
+        imageSize += block.length;
+        compressedSize += block.data.size();
+    }
+
+    message("Firmware image compressed from " + std::to_string(imageSize) +
+            " to " + std::to_string(compressedSize) + " bytes.");
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        m_component->writeCompressedBlock(blocks.at(i));
+
+        message("Block " + std::to_string(i+1) +
+                " of " + std::to_string(blocks.size()) + " written.");
+
+        const int uploadProgress = (i+1) * 100 / blocks.size();
+        const int totalProgress = info.eraseOnWrite ? uploadProgress : 50 + uploadProgress/2;
+        progress(100, uploadProgress, totalProgress);
+    }
+
+    // Completes the image and resets the device's decompression window
+    m_component->writeHexRecord(EndOfFileRecord);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto UploadJob::loadArchive(Component* component) -> FirmwareArchive
+auto UploadJob::writePatch(const Component::BootloaderInfo& info,
+                           const ProgressFunction& progress, const MessageFunction& message) -> bool
+{
+    const std::optional<FirmwareArchive::Delta>& delta = m_archive->delta();
+
+    if (!delta || info.sectorSizes.empty() || info.patchPayloadSize == 0)
+        return false;
+
+    const std::vector<uint8_t> image = makeImage(makeSegments(m_archive->hexRecords()),
+                                                 info.firmwareStartAddress);
+
+    const bool imageMatches = (image.size() == delta->targetLength) &&
+                              (Compressor::checksum(0, image.data(), image.size())
+                               == delta->targetCrc);
+    if (!imageMatches)
+    {
+        message("Delta update doesn't match firmware image, sending full image.");
+        return false;
+    }
+
+    if (!m_component->beginPatch(delta->sourceCrc, delta->targetLength, delta->targetCrc))
+    {
+        message("Delta update doesn't apply to device firmware, sending full image.");
+        return false;
+    }
+
+    const std::vector<PatchEncoder::Block> blocks = PatchEncoder::encode(*delta, image,
+                                                                         info.sectorSizes,
+                                                                         info.patchPayloadSize);
+    size_t patchSize = 0;
+
+    for (const PatchEncoder::Block& block : blocks)
+        patchSize += block.operations.size();
+
+    message("Applying delta update of " + std::to_string(patchSize) +
+            " bytes to build " + std::to_string(image.size()) + " byte image.");
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        m_component->writePatchBlock(blocks.at(i));
+
+        message("Block " + std::to_string(i+1) +
+                " of " + std::to_string(blocks.size()) + " written.");
+
+        const int uploadProgress = (i+1) * 100 / blocks.size();
+        progress(100, uploadProgress, uploadProgress);
+    }
+
+    // Fails if the result doesn't match the image, which is left invalid
+    m_component->finishPatch();
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void UploadJob::checkRecords(uint32_t startAddress, uint32_t endAddress, size_t wordSize,
+                             size_t maximumRecordLength) const
+{
+    const bool checkRange = (endAddress > startAddress);
+    const bool checkLength = (maximumRecordLength > 0);
+
+    for (const FirmwareArchive::DataRecord& record : m_archive->dataRecords())
+    {
+        const std::string line = std::to_string(record.lineNumber);
+
+        if (checkRange)
+        {
+            const bool inRange = (record.address >= startAddress) &&
+                                 (record.address + record.length <= endAddress);
+            if (!inRange)
+            {
+                throw Error("Record on line " + line + " of firmware data is "
+                            "outside of the device's firmware partition.");
+            }
+        }
+
+        if (checkLength && RecordStringOverhead + 2 * record.length > maximumRecordLength)
+        {
+            throw Error("Record on line " + line + " of firmware data exceeds the "
+                        "device's frame size.");
+        }
+
+        if (wordSize > 1)
+        {
+            const bool aligned = (record.address % wordSize) == 0 &&
+                                 (record.length % wordSize) == 0;
+            if (!aligned)
+            {
+                throw Error("Record on line " + line + " of firmware data is not "
+                            "aligned to the device's word size.");
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Runs before the archive is loaded or checked, both of which query the component
+auto UploadJob::checkComponent(Component* component) -> Component*
 {
     assert(component != nullptr);
+    return component;
+}
+
+// ---------------------------------------------------------------------------------------------- //
 
-    const Component::BootloaderInfo info = component->getBootloaderInfo();
+auto UploadJob::loadArchive(Component* component) -> FirmwareArchivePtr
+{
+    const auto [boardName, hardwareVersion] = getHardwareInfo(component);
 
-    const FirmwareArchive archive =
-            FirmwareManager::loadArchive(info.boardName, info.hardwareVersion);
+    FirmwareArchivePtr archive = FirmwareManager::loadArchive(boardName, hardwareVersion);
+    checkMetadata(archive, boardName, hardwareVersion);
 
-    const FirmwareArchive::Metadata& metadata = archive.metadata();
+    return archive;
+}
 
-    if (metadata.boardName != info.boardName)
-        throw Error("Board name in firmware metadata doesn't match target hardware.");
+// ---------------------------------------------------------------------------------------------- //
 
-    if (metadata.hardwareVersion != info.hardwareVersion)
-        throw Error("Hardware version in firmware metadata doesn't match target hardware.");
+auto UploadJob::checkArchive(Component* component,
+                             FirmwareArchivePtr archive) -> FirmwareArchivePtr
+{
+    const auto [boardName, hardwareVersion] = getHardwareInfo(component);
+    checkMetadata(archive, boardName, hardwareVersion);
 
     return archive;
 }
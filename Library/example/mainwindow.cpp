@@ -239,15 +239,6 @@ auto MainWindow::confirmLaunchBootloader(int uniqueId) -> bool
 
 // ---------------------------------------------------------------------------------------------- //
 
-void MainWindow::postLaunchBootloader(int uniqueId)
-{
-    Q_ASSERT(uniqueId == ComponentFactory::NucleoUniqueId);
-    wait(1s, "Waiting for bootloader...");
-
-}
-
-// ---------------------------------------------------------------------------------------------- //
-
 auto MainWindow::confirmLaunchFirmware(int uniqueId) -> bool
 {
     Q_ASSERT(uniqueId == ComponentFactory::NucleoUniqueId);
@@ -262,14 +253,6 @@ auto MainWindow::confirmLaunchFirmware(int uniqueId) -> bool
 
 // ---------------------------------------------------------------------------------------------- //
 
-void MainWindow::postLaunchFirmware(int uniqueId)
-{
-    Q_ASSERT(uniqueId == ComponentFactory::NucleoUniqueId);
-    wait(1s, "Waiting for firmware...");
-}
-
-// ---------------------------------------------------------------------------------------------- //
-
 auto MainWindow::getSerialPort() -> QString
 {
     const auto ports = QSerialPortInfo::availablePorts();
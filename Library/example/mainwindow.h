@@ -45,12 +45,12 @@ private slots:
 
 private:
     auto confirmLaunchBootloader(int uniqueId) -> bool override;
-    void postLaunchBootloader(int uniqueId) override;
-
     auto confirmLaunchFirmware(int uniqueId) -> bool override;
-    void postLaunchFirmware(int uniqueId) override;
 
 #ifdef FIRMWAREUPDATER_BUILD_DUMMY
+    void postLaunchBootloader(int uniqueId) override;
+    void postLaunchFirmware(int uniqueId) override;
+
     auto confirmLaunchMasterBootloader() -> bool;
     auto confirmLaunchSlaveBootloader() -> bool;
 
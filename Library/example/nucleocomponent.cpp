@@ -56,7 +56,16 @@ auto NucleoComponent::getBootloaderInfo() const -> BootloaderInfo
         info.hardwareVersion,
         info.bootloaderVersion,
         info.sectorCount,
-        info.firmwareValid
+        info.firmwareValid,
+        info.firmwareStartAddress,
+        info.firmwareEndAddress,
+        info.wordSize,
+        info.maximumRecordLength,
+        info.eraseOnWrite,
+        info.blockSize,
+        info.blockPayloadSize,
+        info.sectorSizes,
+        info.patchPayloadSize
     };
 }
 
@@ -110,9 +119,74 @@ void NucleoComponent::eraseSector(size_t sector)
 
 // ---------------------------------------------------------------------------------------------- //
 
+void NucleoComponent::eraseSectors(size_t first, size_t count, const SectorFunction& erased)
+{
+    m_device->eraseSectors(first, count, erased);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void NucleoComponent::writeHexRecord(const std::string& record)
 {
     m_device->writeHexRecord(record);
 }
 
 // ---------------------------------------------------------------------------------------------- //
+
+void NucleoComponent::writeCompressedBlock(const CompressedBlock& block)
+{
+    m_device->writeCompressedBlock(block.address, block.length, block.crc, block.data);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto NucleoComponent::beginPatch(uint32_t sourceCrc, uint32_t targetLength,
+                                 uint32_t targetCrc) -> bool
+{
+    return m_device->beginPatch(sourceCrc, targetLength, targetCrc);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void NucleoComponent::writePatchBlock(const PatchBlock& block)
+{
+    m_device->writePatchBlock(block.offset, block.crc, block.operations);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void NucleoComponent::finishPatch()
+{
+    m_device->finishPatch();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto NucleoComponent::getStagingInfo() const -> std::optional<StagingInfo>
+{
+    const std::optional<Device::StagingInfo> info = m_device->getStagingInfo();
+
+    if (!info)
+        return std::nullopt;
+
+    return StagingInfo {
+        info->sectorCount,
+        info->maximumRecordLength
+    };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto NucleoComponent::getStagedFirmwareValid() const -> bool
+{
+    return m_device->getStagedFirmwareValid();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void NucleoComponent::installFirmware()
+{
+    m_device->installFirmware();
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -44,7 +44,18 @@ public:
     void lockFirmware() override;
 
     void eraseSector(size_t sector) override;
+    void eraseSectors(size_t first, size_t count, const SectorFunction& erased) override;
     void writeHexRecord(const std::string& record) override;
+    void writeCompressedBlock(const CompressedBlock& block) override;
+
+    auto beginPatch(uint32_t sourceCrc, uint32_t targetLength, uint32_t targetCrc)
+        -> bool override;
+    void writePatchBlock(const PatchBlock& block) override;
+    void finishPatch() override;
+
+    auto getStagingInfo() const -> std::optional<StagingInfo> override;
+    auto getStagedFirmwareValid() const -> bool override;
+    void installFirmware() override;
 
 private:
     Device* m_device;
@@ -23,6 +23,8 @@
 
 #include "nucleodevice.h"
 
+#include <algorithm>
+
 // ---------------------------------------------------------------------------------------------- //
 
 namespace {
@@ -41,6 +43,49 @@ namespace {
 
         return result;
     }
+
+    auto encodeBase64(const std::vector<uint8_t>& bytes) -> std::string
+    {
+        static constexpr char Alphabet[] =
+                "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string result;
+        result.reserve((bytes.size() + 2) / 3 * 4);
+
+        for (size_t i = 0; i < bytes.size(); i += 3)
+        {
+            const size_t count = std::min<size_t>(3, bytes.size() - i);
+            uint32_t word = 0;
+
+            for (size_t j = 0; j < 3; ++j)
+                word = (word << 8) | (j < count ? bytes[i + j] : 0);
+
+            for (size_t j = 0; j < 4; ++j)
+                result += (j <= count) ? Alphabet[(word >> (18 - 6 * j)) & 0x3f] : '=';
+        }
+
+        return result;
+    }
+
+    void appendLittleEndian(std::vector<uint8_t>* bytes, uint32_t value, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            bytes->push_back(static_cast<uint8_t>(value >> (i*8)));
+    }
+
+    // Tag, separators and the largest sequence number of <WRITE_HEX_RECORD> requests
+    constexpr size_t RecordRequestOverhead = sizeof("<WRITE_HEX_RECORD>  4294967295") - 1;
+
+    // Tag, separators and the largest sequence number of <WRITE_COMPRESSED_BLOCK> requests
+    constexpr size_t BlockRequestOverhead = sizeof("<WRITE_COMPRESSED_BLOCK>  4294967295") - 1;
+
+    // Address, decompressed length and checksum preceding the compressed data
+    constexpr size_t BlockHeaderSize = 10;
+
+    constexpr size_t PatchRequestOverhead = sizeof("<WRITE_PATCH_BLOCK>  4294967295") - 1;
+
+    // Offset and checksum preceding the operations
+    constexpr size_t PatchHeaderSize = 8;
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -54,6 +99,20 @@ public:
 
 // ---------------------------------------------------------------------------------------------- //
 
+class ErrorResponse : public Device::Error
+{
+public:
+    ErrorResponse(const std::string& code, const std::string& message)
+        : Device::Error(message), m_code(code) {}
+
+    auto code() const -> const std::string& { return m_code; }
+
+private:
+    std::string m_code;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
 Device::Device(const char* port)
     : m_port(port) {}
 
@@ -77,13 +136,91 @@ auto Device::getBootMode() const -> BootMode
 
 auto Device::getBootloaderInfo() const -> BootloaderInfo
 {
-    return {
+    BootloaderInfo info = {
         parseString(sendRequest("<GET_BOARD_NAME>"),         "<BOARD_NAME>"),
         parseString(sendRequest("<GET_HARDWARE_VERSION>"),   "<HARDWARE_VERSION>"),
         parseString(sendRequest("<GET_BOOTLOADER_VERSION>"), "<BOOTLOADER_VERSION>"),
         parseULong( sendRequest("<GET_SECTOR_COUNT>"),       "<SECTOR_COUNT>"),
         parseBool(  sendRequest("<GET_FIRMWARE_VALID>"),     "<FIRMWARE_VALID>")
     };
+
+    // Older bootloaders don't report their memory layout
+    try {
+        info.firmwareStartAddress = parseULong(sendRequest("<GET_FIRMWARE_START_ADDRESS>"),
+                                               "<FIRMWARE_START_ADDRESS>");
+
+        info.firmwareEndAddress = parseULong(sendRequest("<GET_FIRMWARE_END_ADDRESS>"),
+                                             "<FIRMWARE_END_ADDRESS>");
+
+        info.wordSize = parseULong(sendRequest("<GET_WORD_SIZE>"), "<WORD_SIZE>");
+    }
+    catch (const Error&) {
+        info.firmwareStartAddress = 0;
+        info.firmwareEndAddress = 0;
+        info.wordSize = 0;
+    }
+
+    try {
+        info.eraseOnWrite = parseBool(sendRequest("<GET_ERASE_ON_WRITE>"), "<ERASE_ON_WRITE>");
+    }
+    catch (const Error&) {
+        info.eraseOnWrite = false;
+    }
+
+    try {
+        info.frameSize = parseULong(sendRequest("<GET_FRAME_SIZE>"), "<FRAME_SIZE>");
+    }
+    catch (const Error&) {
+        info.frameSize = DefaultFrameSize;
+    }
+
+    // Smaller frames than the default are valid as well, e.g. for devices short on RAM
+    m_frameSize = info.frameSize;
+    info.maximumRecordLength = m_frameSize - std::min(m_frameSize, RecordRequestOverhead);
+
+    // Compressed blocks are Base64-encoded, so only 3 bytes are sent in every 4 characters
+    try {
+        info.blockSize = parseULong(sendRequest("<GET_BLOCK_SIZE>"), "<BLOCK_SIZE>");
+
+        const size_t characters = m_frameSize - std::min(m_frameSize, BlockRequestOverhead);
+        const size_t bytes = characters / 4 * 3;
+
+        info.blockPayloadSize = bytes - std::min(bytes, BlockHeaderSize);
+    }
+    catch (const Error&) {
+        info.blockSize = 0;
+    }
+
+    if (info.blockSize == 0 || info.blockPayloadSize < MinimumBlockPayloadSize)
+    {
+        info.blockSize = 0;
+        info.blockPayloadSize = 0;
+    }
+
+    // Delta updates depend on the sector layout, which older bootloaders don't report
+    try {
+        for (size_t sector = 0; sector < info.sectorCount; ++sector)
+        {
+            const std::string request = "<GET_SECTOR_SIZE> " + std::to_string(sector);
+            info.sectorSizes.push_back(parseULong(sendRequest(request), "<SECTOR_SIZE>"));
+        }
+
+        const size_t characters = m_frameSize - std::min(m_frameSize, PatchRequestOverhead);
+        const size_t bytes = characters / 4 * 3;
+
+        info.patchPayloadSize = bytes - std::min(bytes, PatchHeaderSize);
+    }
+    catch (const Error&) {
+        info.sectorSizes.clear();
+    }
+
+    if (info.sectorSizes.empty() || info.patchPayloadSize < MinimumPatchPayloadSize)
+    {
+        info.sectorSizes.clear();
+        info.patchPayloadSize = 0;
+    }
+
+    return info;
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -101,20 +238,26 @@ auto Device::getFirmwareInfo() const -> FirmwareInfo
 
 void Device::launchBootloader()
 {
-    const std::string response = sendRequest("<LAUNCH_BOOTLOADER>");
+    const std::string response = sendRequest("<LAUNCH_BOOTLOADER>", RequestType::Launch);
 
     if (response != "<OK>")
         throw InvalidResponseError(response);
+
+    m_sequenceEchoed = false;
+    waitForBootMode(BootMode::Bootloader);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void Device::launchFirmware()
 {
-    const std::string response = sendRequest("<LAUNCH_FIRMWARE>");
+    const std::string response = sendRequest("<LAUNCH_FIRMWARE>", RequestType::Launch);
 
     if (response != "<OK>")
         throw InvalidResponseError(response);
+
+    m_sequenceEchoed = false;
+    waitForBootMode(BootMode::Firmware);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -125,6 +268,8 @@ void Device::unlockFirmware()
 
     if (response != "<OK>")
         throw InvalidResponseError(response);
+
+    m_sequence = 0;
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -141,8 +286,8 @@ void Device::lockFirmware()
 
 void Device::eraseSector(size_t sector)
 {
-    const auto timeout = 2s;
-    const std::string response = sendRequest("<ERASE_SECTOR> " + std::to_string(sector), timeout);
+    const std::string response = sendRequest("<ERASE_SECTOR> " + std::to_string(sector),
+                                             RequestType::Erase);
 
     if (response != "<OK>")
         throw InvalidResponseError(response);
@@ -150,53 +295,445 @@ void Device::eraseSector(size_t sector)
 
 // ---------------------------------------------------------------------------------------------- //
 
+void Device::eraseSectors(size_t first, size_t count, const SectorFunction& erased)
+{
+    if (m_eraseRangeSupported)
+    {
+        // Each sector is announced before it's erased, which also completes the previous one
+        std::optional<size_t> current;
+
+        auto notification = [&](const std::string& response) {
+            const size_t sector = parseULong(response, "<ERASING>");
+
+            if (current && erased)
+                erased(*current);
+
+            current = sector;
+        };
+
+        try {
+            const std::string response = sendRequest("<ERASE_RANGE> " + std::to_string(first) +
+                                                     " " + std::to_string(count),
+                                                     RequestType::Erase, {}, notification);
+            if (response != "<OK>")
+                throw InvalidResponseError(response);
+
+            if (current && erased)
+                erased(*current);
+
+            return;
+        }
+        catch (const ErrorResponse& e) {
+            if (e.code() != "UNKNOWN_COMMAND")
+                throw;
+
+            m_eraseRangeSupported = false; // Older bootloader, erase one by one instead
+        }
+    }
+
+    for (size_t sector = first; sector < first + count; ++sector)
+    {
+        eraseSector(sector);
+
+        if (erased)
+            erased(sector);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void Device::writeHexRecord(const std::string& record)
 {
-    const auto timeout = 1s;
-    const std::string response = sendRequest("<WRITE_HEX_RECORD> " + record, timeout);
+    // The sequence number allows the device to recognize retransmissions
+    const std::string sequence = std::to_string(++m_sequence);
+    const std::string expectedResponse = "<OK> " + sequence;
+    const std::string request = "<WRITE_HEX_RECORD> " + record + " " + sequence;
+
+    // The device would only discard the line and report a data overflow on every retry. Upload
+    // jobs check records against BootloaderInfo::maximumRecordLength before erasing anything.
+    if (request.size() > m_frameSize)
+        throw Error("Hex record exceeds device frame size of " + std::to_string(m_frameSize)
+                    + " bytes.");
+
+    const std::string response = sendRequest(request, RequestType::Write, expectedResponse);
+
+    // Older bootloaders ignore the sequence number and send a plain acknowledgement
+    if (response == expectedResponse)
+        m_sequenceEchoed = true;
+    else if (response != "<OK>")
+        throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::writeCompressedBlock(uint32_t address, uint32_t length, uint32_t crc,
+                                  const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> block;
+    block.reserve(BlockHeaderSize + data.size());
+
+    appendLittleEndian(&block, address, 4);
+    appendLittleEndian(&block, length, 2);
+    appendLittleEndian(&block, crc, 4);
+
+    block.insert(block.end(), data.begin(), data.end());
+
+    const std::string sequence = std::to_string(++m_sequence);
+    const std::string expectedResponse = "<OK> " + sequence;
+    const std::string request = "<WRITE_COMPRESSED_BLOCK> " + encodeBase64(block) + " " + sequence;
+
+    if (request.size() > m_frameSize)
+        throw Error("Compressed block exceeds device frame size of " + std::to_string(m_frameSize)
+                    + " bytes.");
+
+    m_sequenceEchoed = true; // Always the case for devices accepting blocks
+
+    const std::string response = sendRequest(request, RequestType::Write, expectedResponse);
+
+    if (response != expectedResponse)
+        throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// The device checks its image and invalidates it, so this may take as long as erasing
+auto Device::beginPatch(uint32_t sourceCrc, uint32_t targetLength, uint32_t targetCrc) -> bool
+{
+    const std::string request = "<BEGIN_PATCH> " + std::to_string(sourceCrc) + " " +
+                                std::to_string(targetLength) + " " + std::to_string(targetCrc);
+    std::string response;
+
+    try {
+        response = sendRequest(request, RequestType::Erase);
+    }
+    catch (const ErrorResponse& e) {
+        const bool unsupported = (e.code() == "SOURCE_MISMATCH" ||
+                                  e.code() == "PATCHING_DISABLED" ||
+                                  e.code() == "UNKNOWN_COMMAND");
+        if (unsupported)
+            return false;
+
+        throw;
+    }
 
     if (response != "<OK>")
         throw InvalidResponseError(response);
+
+    return true;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Device::sendRequest(std::string request,
-                         std::chrono::milliseconds timeout) const -> std::string
+// Blocks entering a new sector are preceded by <ERASING> notifications while it's backed up
+void Device::writePatchBlock(uint32_t offset, uint32_t crc,
+                             const std::vector<uint8_t>& operations)
 {
-    static constexpr size_t MaximumResponseSize = 64;
+    std::vector<uint8_t> block;
+    block.reserve(PatchHeaderSize + operations.size());
 
-    static const std::string lineBreak = "\r\n";
+    appendLittleEndian(&block, offset, 4);
+    appendLittleEndian(&block, crc, 4);
 
-    request += "\r\n";
-    m_port.sendData(request);
+    block.insert(block.end(), operations.begin(), operations.end());
 
-    std::string response;
+    const std::string sequence = std::to_string(++m_sequence);
+    const std::string expectedResponse = "<OK> " + sequence;
+    const std::string request = "<WRITE_PATCH_BLOCK> " + encodeBase64(block) + " " + sequence;
 
-    while (true)
+    if (request.size() > m_frameSize)
+        throw Error("Patch block exceeds device frame size of " + std::to_string(m_frameSize)
+                    + " bytes.");
+
+    m_sequenceEchoed = true; // Always the case for devices accepting blocks
+
+    const std::string response = sendRequest(request, RequestType::Write, expectedResponse);
+
+    if (response != expectedResponse)
+        throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::finishPatch()
+{
+    const std::string response = sendRequest("<FINISH_PATCH>", RequestType::Erase);
+
+    if (response != "<OK>")
+        throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Bootloaders answer the probe with UNKNOWN_COMMAND, as does firmware that doesn't stage updates
+auto Device::getStagingInfo() const -> std::optional<StagingInfo>
+{
+    try {
+        getStagedFirmwareValid();
+    }
+    catch (const ErrorResponse& e) {
+        if (e.code() == "UNKNOWN_COMMAND")
+            return std::nullopt;
+
+        throw;
+    }
+
+    StagingInfo info = {
+        parseULong(sendRequest("<GET_SECTOR_COUNT>"), "<SECTOR_COUNT>")
+    };
+
+    // Firmware built without a staging slot still answers, but can't stage anything
+    if (info.sectorCount == 0)
+        return std::nullopt;
+
+    try {
+        info.frameSize = parseULong(sendRequest("<GET_FRAME_SIZE>"), "<FRAME_SIZE>");
+    }
+    catch (const Error&) {
+        info.frameSize = DefaultFrameSize;
+    }
+
+    m_frameSize = info.frameSize;
+    info.maximumRecordLength = m_frameSize - std::min(m_frameSize, RecordRequestOverhead);
+
+    return info;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getStagedFirmwareValid() const -> bool
+{
+    return parseBool(sendRequest("<GET_STAGED_FIRMWARE_VALID>"), "<STAGED_FIRMWARE_VALID>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// The firmware checks the staged image before it resets, so an invalid one is reported as an
+// error and the device keeps running
+void Device::installFirmware()
+{
+    const std::string response = sendRequest("<INSTALL_FIRMWARE>", RequestType::Launch);
+
+    if (response != "<OK>")
+        throw InvalidResponseError(response);
+
+    m_sequenceEchoed = false;
+    waitForBootMode(BootMode::Firmware, MaximumInstallTime);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::sendRequest(const std::string& request, RequestType type,
+                         const std::string& expectedResponse,
+                         const NotificationFunction& notification) const -> std::string
+{
+    using namespace std::chrono;
+
+    RttEstimator& rtt = estimator(type);
+
+    const size_t attempts = (type == RequestType::Launch) ? 1 : MaximumAttempts;
+
+    // Only acknowledgements of writes to a device echoing sequence numbers identify their request
+    const bool tagged = !expectedResponse.empty() && m_sequenceEchoed;
+    const std::string data = request + "\r\n";
+
+    for (size_t attempt = 1; ; ++attempt)
     {
-        const bool dataAvailable = m_port.waitForDataAvailable(timeout);
+        const bool lastAttempt = (attempt == attempts);
 
-        if (!dataAvailable)
-            throw Error("Request timed out.");
+        // Discard anything left over from a previous attempt
+        m_statistics.bytesReceived += m_port.readAllData().size();
+        m_receiveBuffer.clear();
 
-        const std::vector<char> data = m_port.readAllData();
+        const auto start = steady_clock::now();
+        auto deadline = start + rtt.timeout();
 
-        if (response.size() + data.size() > MaximumResponseSize)
-            throw Error("Invalid response length.");
+        bool notified = false;
+
+        m_port.sendData(data);
+
+        ++m_statistics.requests;
+        m_statistics.bytesSent += data.size();
 
-        for (char c : data)
+        if (attempt > 1)
+            ++m_statistics.retries;
+
+        std::optional<std::string> response;
+
+        while ((response = readResponse(deadline)))
+        {
+            if (isNotification(*response))
+            {
+                if (notification)
+                    notification(*response);
+
+                deadline = steady_clock::now() + MaximumEraseTime;
+                notified = true;
+                continue;
+            }
+
+            // Late acknowledgements of previous sequence numbers are stale, whatever the request.
+            // Only sequenced writes are acknowledged with an argument, and once the device has
+            // echoed a sequence number, a plain acknowledgement can't belong to one of them.
+            const bool stale = (response->starts_with("<OK> ") && *response != expectedResponse) ||
+                               (tagged && *response == "<OK>");
+            if (!stale)
+                break;
+        }
+
+        if (!response)
         {
-            response += c;
+            rtt.backOff();
 
-            if (response.ends_with(lineBreak))
+            if (lastAttempt)
             {
-                response.erase(response.size() - lineBreak.size());
+                // The response may still arrive and would be taken for that of the next request
+                if (!tagged)
+                    resynchronize(rtt.timeout());
 
-                checkError(response);
-                return response;
+                throw Error("Request timed out.");
             }
+
+            continue;
         }
+
+        // Otherwise, the response may have answered an earlier attempt, and those to any later
+        // ones must not be taken for that of the next request
+        if (attempt > 1 && !tagged)
+            resynchronize(rtt.timeout());
+
+        // Only use unambiguous round trips as samples (Karn's algorithm), and leave out those
+        // that included an erase
+        if (attempt == 1 && !notified)
+            rtt.addSample(duration_cast<microseconds>(steady_clock::now() - start));
+
+        if (!lastAttempt && isTransientError(*response))
+            continue;
+
+        checkError(*response);
+        return *response;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::readResponse(std::chrono::steady_clock::time_point deadline) const
+    -> std::optional<std::string>
+{
+    using namespace std::chrono;
+
+    static const std::string lineBreak = "\r\n";
+
+    while (true)
+    {
+        const size_t end = m_receiveBuffer.find(lineBreak);
+
+        if (end != std::string::npos)
+        {
+            std::string response = m_receiveBuffer.substr(0, end);
+            m_receiveBuffer.erase(0, end + lineBreak.size());
+
+            return response;
+        }
+
+        // Responses are limited to the same frame size as requests
+        if (m_receiveBuffer.size() > m_frameSize + lineBreak.size())
+            throw Error("Invalid response length.");
+
+        const auto remaining = ceil<milliseconds>(deadline - steady_clock::now());
+
+        if (remaining <= 0ms || !m_port.waitForDataAvailable(remaining))
+            return std::nullopt;
+
+        const std::vector<char> data = m_port.readAllData();
+        m_statistics.bytesReceived += data.size();
+
+        m_receiveBuffer.append(data.begin(), data.end());
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::resynchronize(std::chrono::milliseconds quietTime) const
+{
+    m_receiveBuffer.clear();
+
+    while (m_port.waitForDataAvailable(quietTime))
+        m_statistics.bytesReceived += m_port.readAllData().size();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// The device resets as soon as it has sent its response, so it's usually ready again after a few
+// milliseconds rather than after a fixed delay
+void Device::waitForBootMode(BootMode mode, std::chrono::milliseconds timeout) const
+{
+    using namespace std::chrono;
+
+    const auto deadline = steady_clock::now() + timeout;
+    milliseconds probeTimeout = FirstProbeTimeout;
+
+    while (true)
+    {
+        const std::optional<BootMode> currentMode = probeBootMode(probeTimeout);
+
+        if (currentMode == mode)
+            return;
+
+        if (currentMode)
+            throw Error("Device restarted in unexpected boot mode.");
+
+        if (steady_clock::now() >= deadline)
+            throw Error("Device did not respond after reset.");
+
+        probeTimeout = std::min<milliseconds>(2 * probeTimeout, MaximumProbeTimeout);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::probeBootMode(std::chrono::milliseconds timeout) const -> std::optional<BootMode>
+{
+    using namespace std::chrono;
+
+    static const std::string request = "<GET_BOOT_MODE>\r\n";
+
+    m_statistics.bytesReceived += m_port.readAllData().size();
+    m_receiveBuffer.clear();
+
+    m_port.sendData(request);
+
+    ++m_statistics.requests;
+    m_statistics.bytesSent += request.size();
+
+    const auto deadline = steady_clock::now() + timeout;
+
+    // Noise on the line during the reset may garble the first response
+    while (const std::optional<std::string> response = readResponse(deadline))
+    {
+        if (*response == "<BOOT_MODE> BOOTLOADER")
+            return BootMode::Bootloader;
+
+        if (*response == "<BOOT_MODE> FIRMWARE")
+            return BootMode::Firmware;
+    }
+
+    return std::nullopt;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::estimator(RequestType type) const -> RttEstimator&
+{
+    switch (type)
+    {
+    case RequestType::Erase:
+        return m_eraseEstimator;
+
+    case RequestType::Write:
+        return m_writeEstimator;
+
+    default:
+        return m_queryEstimator;
     }
 }
 
@@ -209,7 +746,7 @@ void Device::checkError(const std::string& response) const
     if (tag == "<ERROR>")
     {
         const std::string error = response.substr(tag.length() + 1);
-        throw Error(mapError(error));
+        throw ErrorResponse(error, mapError(error));
     }
 }
 
@@ -252,6 +789,35 @@ auto Device::parseBool(const std::string& response,
 
 // ---------------------------------------------------------------------------------------------- //
 
+auto Device::isNotification(const std::string& response) -> bool
+{
+    // Sent ahead of the actual response, e.g. when a write has to erase a sector first
+    return response.starts_with("<ERASING>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::isTransientError(const std::string& response) -> bool
+{
+    // These are typically caused by corrupted requests and can be resolved by retransmission.
+    // UNKNOWN_COMMAND is left out, as it's the expected answer to probes for newer commands.
+    static const std::vector<std::string> transientErrors = {
+        "<ERROR> DATA_OVERFLOW",
+        "<ERROR> MISSING_PARAMETER",
+        "<ERROR> INVALID_RECORD",
+        "<ERROR> INVALID_LENGTH",
+        "<ERROR> INVALID_TYPE",
+        "<ERROR> INVALID_CHECKSUM",
+        "<ERROR> INVALID_BLOCK",
+        "<ERROR> INVALID_DATA"
+    };
+
+    return std::find(transientErrors.begin(), transientErrors.end(),
+                     response) != transientErrors.end();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 auto Device::mapError(const std::string& error) -> std::string
 {
     if (error == "DATA_OVERFLOW")
@@ -260,7 +826,7 @@ auto Device::mapError(const std::string& error) -> std::string
     if (error == "UNKNOWN_COMMAND")
         return "Unknown command.";
 
-    if (error == "MISSING_ARGUMENT")
+    if (error == "MISSING_ARGUMENT" || error == "MISSING_PARAMETER")
         return "Missing argument.";
 
     if (error == "INVALID_ARGUMENT")
@@ -275,9 +841,18 @@ auto Device::mapError(const std::string& error) -> std::string
     if (error == "INVALID_LENGTH")
         return "Invalid length.";
 
+    if (error == "INVALID_TYPE")
+        return "Invalid type.";
+
     if (error == "INVALID_CHECKSUM")
         return "Invalid checksum.";
 
+    if (error == "INVALID_BLOCK")
+        return "Invalid block.";
+
+    if (error == "INVALID_DATA")
+        return "Invalid data.";
+
     if (error == "INVALID_SECTOR")
         return "Invalid sector.";
 
@@ -293,6 +868,30 @@ auto Device::mapError(const std::string& error) -> std::string
     if (error == "DATA_MISMATCH")
         return "Data mismatch.";
 
+    if (error == "ALREADY_PROGRAMMED")
+        return "Address already programmed.";
+
+    if (error == "PATCHING_DISABLED")
+        return "Delta updates disabled.";
+
+    if (error == "SOURCE_MISMATCH")
+        return "Firmware doesn't match base of delta update.";
+
+    if (error == "PATCH_NOT_STARTED")
+        return "Delta update not started.";
+
+    if (error == "INVALID_PATCH")
+        return "Invalid delta update.";
+
+    if (error == "TARGET_MISMATCH")
+        return "Delta update result doesn't match firmware image.";
+
+    if (error == "STAGING_DISABLED")
+        return "Staging disabled.";
+
+    if (error == "STAGED_FIRMWARE_INVALID")
+        return "Staged firmware image is invalid.";
+
     return "Unknown error code received: " + error;
 }
 
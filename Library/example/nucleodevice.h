@@ -23,10 +23,14 @@
 
 #pragma once
 
+#include "rttestimator.h"
 #include "serialport.h"
 
+#include <functional>
 #include <memory>
+#include <optional>
 #include <stdexcept>
+#include <vector>
 
 class Device;
 using DevicePtr = std::unique_ptr<Device>;
@@ -47,6 +51,16 @@ public:
         std::string bootloaderVersion;
         size_t sectorCount;
         bool firmwareValid;
+        uint32_t firmwareStartAddress = 0;
+        uint32_t firmwareEndAddress = 0;
+        size_t wordSize = 0;
+        bool eraseOnWrite = false;
+        size_t frameSize = 0;
+        size_t maximumRecordLength = 0;
+        size_t blockSize = 0;
+        size_t blockPayloadSize = 0;
+        std::vector<size_t> sectorSizes = {};
+        size_t patchPayloadSize = 0;
     };
 
     struct FirmwareInfo
@@ -56,8 +70,26 @@ public:
         std::string firmwareVersion;
     };
 
+    struct StagingInfo
+    {
+        size_t sectorCount;
+        size_t frameSize = 0;
+        size_t maximumRecordLength = 0;
+    };
+
+    // Traffic counters, including retransmissions and discarded responses
+    struct Statistics
+    {
+        size_t requests = 0;
+        size_t retries = 0;
+        size_t bytesSent = 0;
+        size_t bytesReceived = 0;
+    };
+
     using Error = std::runtime_error;
 
+    using SectorFunction = std::function<void(size_t sector)>;
+
 public:
     Device(const char* port);
 
@@ -72,13 +104,75 @@ public:
     void unlockFirmware();
     void lockFirmware();
     void eraseSector(size_t);
+    void eraseSectors(size_t first, size_t count, const SectorFunction& erased = {});
     void writeHexRecord(const std::string&);
+    void writeCompressedBlock(uint32_t address, uint32_t length, uint32_t crc,
+                              const std::vector<uint8_t>& data);
+
+    // Returns false if the device can't apply the patch to its current image
+    auto beginPatch(uint32_t sourceCrc, uint32_t targetLength, uint32_t targetCrc) -> bool;
+    void writePatchBlock(uint32_t offset, uint32_t crc, const std::vector<uint8_t>& operations);
+    void finishPatch();
+
+    // Only answered by firmware that stages updates, empty otherwise
+    auto getStagingInfo() const -> std::optional<StagingInfo>;
+    auto getStagedFirmwareValid() const -> bool;
+
+    // Resets the device, whose bootloader then installs the staged image
+    void installFirmware();
+
+    auto statistics() const -> const Statistics& { return m_statistics; }
+    void resetStatistics() { m_statistics = {}; }
 
 private:
-    static constexpr auto DefaultTimeout = SerialPort::DefaultTimeout;
+    enum class RequestType
+    {
+        Query,   // Idempotent, short processing time
+        Launch,  // Resets the device, never retried
+        Erase,   // Idempotent, long processing time
+        Write    // Made idempotent by sequence numbers
+    };
+
+    static constexpr size_t MaximumAttempts = 4;
+
+    // Line length of bootloaders that don't report Config::MaximumFrameSize
+    static constexpr size_t DefaultFrameSize = 80;
+
+    // Below this, compressed blocks don't save enough to make up for the Base64 encoding
+    static constexpr size_t MinimumBlockPayloadSize = 32;
 
-    auto sendRequest(std::string request,
-                     std::chrono::milliseconds timeout = DefaultTimeout) const -> std::string;
+    // Leaves room for at least two copy operations per patch block
+    static constexpr size_t MinimumPatchPayloadSize = 16;
+
+    // Allowed per sector the device announces to erase before responding
+    static constexpr auto MaximumEraseTime = 10s;
+
+    // The device is probed for its boot mode after a reset, waiting longer after each attempt
+    static constexpr auto FirstProbeTimeout = 10ms;
+    static constexpr auto MaximumProbeTimeout = 250ms;
+    static constexpr auto MaximumResetTime = 5s;
+
+    // The bootloader copies the staged image before it launches the firmware again
+    static constexpr auto MaximumInstallTime = 30s;
+
+    using NotificationFunction = std::function<void(const std::string& notification)>;
+
+    auto sendRequest(const std::string& request, RequestType type = RequestType::Query,
+                     const std::string& expectedResponse = {},
+                     const NotificationFunction& notification = {}) const -> std::string;
+
+    auto readResponse(std::chrono::steady_clock::time_point deadline) const
+        -> std::optional<std::string>;
+
+    // Discards whatever the device sends until the line has been quiet for the given time, such
+    // as the second response to a request that was sent twice
+    void resynchronize(std::chrono::milliseconds quietTime) const;
+
+    void waitForBootMode(BootMode mode,
+                         std::chrono::milliseconds timeout = MaximumResetTime) const;
+    auto probeBootMode(std::chrono::milliseconds timeout) const -> std::optional<BootMode>;
+
+    auto estimator(RequestType type) const -> RttEstimator&;
 
     void checkError(const std::string& response) const;
 
@@ -91,8 +185,30 @@ private:
     auto parseBool(const std::string& response,
                    const std::string& expectedTag) const -> bool;
 
+    static auto isNotification(const std::string& response) -> bool;
+    static auto isTransientError(const std::string& response) -> bool;
     static auto mapError(const std::string& error) -> std::string;
 
 private:
     SerialPort m_port;
+
+    mutable std::string m_receiveBuffer;
+
+    // Updated by getBootloaderInfo() and getStagingInfo() from the device's <FRAME_SIZE> response
+    mutable size_t m_frameSize = DefaultFrameSize;
+
+    mutable RttEstimator m_queryEstimator = { SerialPort::DefaultTimeout, 100ms, 2s };
+    mutable RttEstimator m_eraseEstimator = { 2s, 500ms, 10s };
+    mutable RttEstimator m_writeEstimator = { 1s, 100ms, 4s };
+
+    unsigned long m_sequence = 0;
+
+    // Set once the device echoes sequence numbers, plain acknowledgements of writes are then stale.
+    // Cleared when the device resets, as the other boot mode may not echo them.
+    bool m_sequenceEchoed = false;
+
+    // Cleared once the bootloader turns out not to support <ERASE_RANGE>
+    bool m_eraseRangeSupported = true;
+
+    mutable Statistics m_statistics;
 };
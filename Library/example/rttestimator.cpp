@@ -0,0 +1,86 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "rttestimator.h"
+
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr RttEstimator::Duration ClockGranularity = std::chrono::milliseconds(1);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+RttEstimator::RttEstimator(std::chrono::milliseconds initialTimeout,
+                           std::chrono::milliseconds minimumTimeout,
+                           std::chrono::milliseconds maximumTimeout)
+    : m_minimumTimeout(minimumTimeout),
+      m_maximumTimeout(maximumTimeout),
+      m_timeout(initialTimeout) {}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RttEstimator::timeout() const -> std::chrono::milliseconds
+{
+    return std::chrono::ceil<std::chrono::milliseconds>(m_timeout);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RttEstimator::addSample(Duration rtt)
+{
+    if (!m_hasSamples)
+    {
+        m_smoothedRtt = rtt;
+        m_rttVariation = rtt / 2;
+        m_hasSamples = true;
+    }
+    else
+    {
+        const Duration deviation = (m_smoothedRtt > rtt) ? m_smoothedRtt - rtt
+                                                         : rtt - m_smoothedRtt;
+
+        m_rttVariation = (3 * m_rttVariation + deviation) / 4;
+        m_smoothedRtt = (7 * m_smoothedRtt + rtt) / 8;
+    }
+
+    m_timeout = bounded(m_smoothedRtt + std::max(ClockGranularity, 4 * m_rttVariation));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RttEstimator::backOff()
+{
+    m_timeout = bounded(2 * m_timeout);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RttEstimator::bounded(Duration timeout) const -> Duration
+{
+    return std::clamp(timeout, m_minimumTimeout, m_maximumTimeout);
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,58 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater library.                                        //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This library is free software: you can redistribute it and/or modify it under the terms of    //
+//  the GNU Lesser General Public License as published by the Free Software Foundation, either    //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU Lesser General Public License for more details.                                   //
+//                                                                                                //
+//  You should have received a copy of the GNU Lesser General Public License along with this      //
+//  library. If not, see <https://www.gnu.org/licenses/>.                                         //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <chrono>
+
+// Derives request timeouts from measured round-trip times following RFC 6298. Samples must
+// only be taken from requests that were answered on their first transmission (Karn's rule).
+
+class RttEstimator
+{
+public:
+    using Duration = std::chrono::microseconds;
+
+public:
+    RttEstimator(std::chrono::milliseconds initialTimeout,
+                 std::chrono::milliseconds minimumTimeout,
+                 std::chrono::milliseconds maximumTimeout);
+
+    auto timeout() const -> std::chrono::milliseconds;
+
+    void addSample(Duration rtt);
+    void backOff();
+
+private:
+    auto bounded(Duration timeout) const -> Duration;
+
+private:
+    Duration m_minimumTimeout;
+    Duration m_maximumTimeout;
+
+    Duration m_timeout;
+    Duration m_smoothedRtt = {};
+    Duration m_rttVariation = {};
+
+    bool m_hasSamples = false;
+};
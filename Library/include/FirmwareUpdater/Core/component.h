@@ -25,8 +25,12 @@
 
 #include <FirmwareUpdater/Core/namespace.h>
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 FIRMWAREUPDATER_BEGIN_NAMESPACE();
 
@@ -49,6 +53,43 @@ public:
         std::string bootloaderVersion;
         size_t sectorCount;
         bool firmwareValid;
+
+        // Used to validate firmware images before uploading, zero if not reported by the device
+        uint32_t firmwareStartAddress = 0;
+        uint32_t firmwareEndAddress = 0;
+        size_t wordSize = 0;
+        size_t maximumRecordLength = 0; // Characters of a hex record sent in a single request
+
+        // Sectors are erased by the device when first written, so no erase phase is needed
+        bool eraseOnWrite = false;
+
+        // Images are sent as compressed blocks if both are reported, zero otherwise. The block
+        // size limits the decompressed length, the payload size the compressed one.
+        size_t blockSize = 0;
+        size_t blockPayloadSize = 0;
+
+        // Delta updates are applied if both are reported, empty or zero otherwise. Sizes are in
+        // bytes for each sector of the firmware partition, the payload size limits the
+        // operations of a patch block.
+        std::vector<size_t> sectorSizes = {};
+        size_t patchPayloadSize = 0;
+    };
+
+    // LZSS-compressed image data in the format of the bootloader's Decompressor
+    struct CompressedBlock
+    {
+        uint32_t address;
+        uint32_t length; // Decompressed length
+        uint32_t crc;    // CRC-32 of address, length and decompressed data
+        std::vector<uint8_t> data;
+    };
+
+    // Delta operations in the format of the bootloader's Patcher
+    struct PatchBlock
+    {
+        uint32_t offset; // Relative to the start of the firmware partition
+        uint32_t crc;    // CRC-32 of offset and operations
+        std::vector<uint8_t> operations;
     };
 
     struct FirmwareInfo
@@ -58,6 +99,16 @@ public:
         std::string firmwareVersion;
     };
 
+    // Reported by firmware that writes updates into a staging slot while it keeps running. The
+    // bootloader installs the staged image on the next reset.
+    struct StagingInfo
+    {
+        size_t sectorCount;
+        size_t maximumRecordLength = 0; // Characters of a hex record sent in a single request
+    };
+
+    using SectorFunction = std::function<void(size_t sector)>;
+
 public:
     virtual ~Component() = default;
 
@@ -73,7 +124,29 @@ public:
     virtual void lockFirmware() = 0;
 
     virtual void eraseSector(size_t sector) = 0;
+
+    // Erased one by one unless overridden, calls the function as each sector completes
+    virtual void eraseSectors(size_t first, size_t count, const SectorFunction& erased = {});
     virtual void writeHexRecord(const std::string& record) = 0;
+
+    // Only called if block sizes are reported, throws unless overridden
+    virtual void writeCompressedBlock(const CompressedBlock& block);
+
+    // Only called if sector sizes are reported. Returns false if the device can't apply the
+    // patch to its current image, which is then left untouched. The others throw unless
+    // overridden.
+    virtual auto beginPatch(uint32_t sourceCrc, uint32_t targetLength, uint32_t targetCrc) -> bool;
+    virtual void writePatchBlock(const PatchBlock& block);
+    virtual void finishPatch();
+
+    // Only called in firmware mode, returns no info unless overridden. While staging, unlocking,
+    // erasing and writing address the staging slot rather than the firmware partition.
+    virtual auto getStagingInfo() const -> std::optional<StagingInfo>;
+
+    // Only called if staging info is reported, both throw unless overridden. Installing resets
+    // the device and returns once the new firmware is running.
+    virtual auto getStagedFirmwareValid() const -> bool;
+    virtual void installFirmware();
 };
 
 FIRMWAREUPDATER_END_NAMESPACE();
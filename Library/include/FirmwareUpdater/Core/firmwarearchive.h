@@ -25,7 +25,9 @@
 
 #include <FirmwareUpdater/Core/namespace.h>
 
-#include <map>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -46,6 +48,26 @@ public:
 
     using StringList = std::vector<std::string>;
 
+    struct DataRecord
+    {
+        size_t lineNumber;
+        uint32_t address; // Absolute address after applying extended linear address records
+        size_t length;
+    };
+
+    using DataRecordList = std::vector<DataRecord>;
+
+    // Optional delta update from a previous version, with offsets relative to the start of the
+    // image. The operations are in the format of the bootloader's Patcher.
+    struct Delta
+    {
+        uint32_t sourceLength;
+        uint32_t sourceCrc;
+        uint32_t targetLength;
+        uint32_t targetCrc;
+        std::vector<uint8_t> operations;
+    };
+
     using Error = std::runtime_error;
 
 public:
@@ -53,14 +75,26 @@ public:
 
     auto metadata() const -> const Metadata&;
     auto hexRecords() const -> const StringList&;
+    auto dataRecords() const -> const DataRecordList&;
+    auto delta() const -> const std::optional<Delta>&;
 
+    // Keys may be registered, replaced and removed at any time. An archive being loaded
+    // concurrently is verified with the key registered once its metadata has been parsed.
     static void registerPublicKey(const std::string& packager, const std::string& key);
+    static void unregisterPublicKey(const std::string& packager);
+
+    // Changes whenever a key is registered, replaced or removed, so that archives verified
+    // with a previous set of keys can be told apart
+    static auto publicKeyGeneration() -> uint64_t;
 
 private:
     Metadata m_metadata;
     StringList m_hexRecords;
-
-    static std::map<std::string,std::string> s_publicKeys;
+    DataRecordList m_dataRecords;
+    std::optional<Delta> m_delta;
 };
 
+// Archives are immutable once loaded, so a single instance can be shared by any number of jobs
+using FirmwareArchivePtr = std::shared_ptr<const FirmwareArchive>;
+
 FIRMWAREUPDATER_END_NAMESPACE();
@@ -39,7 +39,7 @@ public:
                                     const std::string& hardwareVersion) -> std::string;
 
     static auto loadArchive(const std::string& boardName,
-                            const std::string& hardwareVersion) -> FirmwareArchive;
+                            const std::string& hardwareVersion) -> FirmwareArchivePtr;
 };
 
 FIRMWAREUPDATER_END_NAMESPACE();
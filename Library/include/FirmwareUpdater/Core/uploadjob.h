@@ -41,16 +41,44 @@ public:
 
 public:
     UploadJob(Component* component);
+    UploadJob(Component* component, FirmwareArchivePtr archive);
 
     void run(const ProgressFunction& progress = nullptr,
              const MessageFunction& message = nullptr);
 
 private:
-    static auto loadArchive(Component* component) -> FirmwareArchive;
+    // Used if the device runs firmware that stages updates. Its bootloader installs the staged
+    // image on the next reset, so the firmware keeps running until then.
+    void stageFirmware(const Component::StagingInfo& info,
+                       const ProgressFunction& progress, const MessageFunction& message);
+
+    void eraseSectors(size_t count,
+                      const ProgressFunction& progress, const MessageFunction& message);
+
+    void writeRecords(bool eraseOnWrite,
+                      const ProgressFunction& progress, const MessageFunction& message);
+
+    // Used if the device reports block sizes, the end of file is still sent as a record
+    void writeBlocks(const Component::BootloaderInfo& info,
+                     const ProgressFunction& progress, const MessageFunction& message);
+
+    // Used if the archive contains a delta update and the device reports its sectors. Returns
+    // false if the delta doesn't apply to the device's current image, before anything is written.
+    auto writePatch(const Component::BootloaderInfo& info,
+                    const ProgressFunction& progress, const MessageFunction& message) -> bool;
+
+    // Limits that are zero aren't checked
+    void checkRecords(uint32_t startAddress, uint32_t endAddress, size_t wordSize,
+                      size_t maximumRecordLength) const;
+
+    static auto checkComponent(Component* component) -> Component*;
+    static auto loadArchive(Component* component) -> FirmwareArchivePtr;
+    static auto checkArchive(Component* component,
+                             FirmwareArchivePtr archive) -> FirmwareArchivePtr;
 
 private:
     Component* m_component;
-    const FirmwareArchive m_archive;
+    const FirmwareArchivePtr m_archive;
 };
 
 FIRMWAREUPDATER_END_NAMESPACE();
@@ -0,0 +1,387 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater software.                                       //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "delta.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <map>
+#include <sstream>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace DeltaPrivate {
+
+    using Delta::ByteArray;
+    using Delta::Error;
+
+    constexpr uint8_t CopyCode = 0x80;
+    constexpr size_t MaximumCopyLength = std::numeric_limits<uint16_t>::max();
+    constexpr size_t MaximumInsertLength = 127;
+
+    // A copy takes 7 bytes, so shorter matches are better sent as literals
+    constexpr size_t MinimumCopyLength = 8;
+
+    // Source positions are indexed by the hash of the following bytes
+    constexpr size_t KeySize = 8;
+    constexpr size_t HashBits = 16;
+    constexpr size_t MaximumChainLength = 64;
+
+    constexpr uint8_t ErasedValue = 0xff;
+
+    class Encoder;
+
+    auto hash(const uint8_t* bytes) -> uint32_t;
+    auto parseHexByte(const std::string& line, size_t index) -> uint8_t;
+
+    void appendLittleEndian(ByteArray* bytes, uint32_t value, size_t count);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace DeltaPrivate;
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Greedy matching along hash chains. Firmware changes mostly shift code and data around, so the
+// offset of the previous copy is tried first and usually continues right after a literal.
+class DeltaPrivate::Encoder
+{
+public:
+    Encoder(const ByteArray& source, const ByteArray& target);
+
+    auto encode() -> ByteArray;
+
+private:
+    auto matchLength(size_t source, size_t target) const -> size_t;
+
+    void copy(size_t source, size_t length);
+    void insert(size_t first, size_t last);
+
+private:
+    const ByteArray& m_source;
+    const ByteArray& m_target;
+
+    std::vector<int32_t> m_head;
+    std::vector<int32_t> m_previous;
+
+    ByteArray m_operations;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Delta::parseHexFile(const std::string& text) -> Image
+{
+    std::map<uint32_t, uint8_t> bytes;
+
+    std::istringstream stream(text);
+    std::string line;
+
+    uint32_t baseAddress = 0;
+    size_t lineNumber = 0;
+    bool endOfFile = false;
+
+    while (std::getline(stream, line) && !endOfFile)
+    {
+        ++lineNumber;
+
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+            line.pop_back();
+
+        if (line.empty())
+            continue;
+
+        const std::string location = " on line " + std::to_string(lineNumber) + ".";
+
+        if (line.front() != ':' || line.size() < 11 || line.size() % 2 == 0)
+            throw Error("Invalid record in hex file" + location);
+
+        ByteArray record;
+        uint8_t sum = 0;
+
+        for (size_t i = 1; i < line.size(); i += 2)
+        {
+            record.push_back(parseHexByte(line, i));
+            sum += record.back();
+        }
+
+        if (sum != 0 || record.at(0) + 5u != record.size())
+            throw Error("Invalid record in hex file" + location);
+
+        const uint32_t address = (record[1] << 8) | record[2];
+        const uint8_t type = record[3];
+
+        switch (type)
+        {
+        case 0x00:
+            for (size_t i = 0; i < record[0]; ++i)
+                bytes[baseAddress + address + i] = record[4 + i];
+            break;
+
+        case 0x01:
+            endOfFile = true;
+            break;
+
+        case 0x04:
+            if (record[0] != 2)
+                throw Error("Invalid record in hex file" + location);
+
+            baseAddress = (record[4] << 24) | (record[5] << 16);
+            break;
+
+        case 0x03:
+        case 0x05:
+            break;
+
+        default:
+            throw Error("Unsupported record type in hex file" + location);
+        }
+    }
+
+    if (bytes.empty())
+        throw Error("Hex file doesn't contain any data.");
+
+    const uint32_t first = bytes.begin()->first;
+    const uint32_t last = bytes.rbegin()->first;
+
+    Image image = { first, ByteArray(last - first + 1, ErasedValue) };
+
+    for (const auto& [address, value] : bytes)
+        image.data[address - first] = value;
+
+    return image;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Delta::create(const Image& source, const Image& target) -> ByteArray
+{
+    if (source.address != target.address)
+        throw Error("Base image doesn't start at the same address as the firmware image.");
+
+    ByteArray delta;
+
+    appendLittleEndian(&delta, source.data.size(), 4);
+    appendLittleEndian(&delta, checksum(source.data), 4);
+    appendLittleEndian(&delta, target.data.size(), 4);
+    appendLittleEndian(&delta, checksum(target.data), 4);
+
+    const ByteArray operations = Encoder(source.data, target.data).encode();
+    delta.insert(delta.end(), operations.begin(), operations.end());
+
+    return delta;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Delta::checksum(const ByteArray& data) -> uint32_t
+{
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> table = {};
+
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+
+            table[i] = crc;
+        }
+
+        return table;
+    }();
+
+    uint32_t crc = 0;
+
+    for (uint8_t byte : data)
+        crc = (crc >> 8) ^ table[(crc ^ byte) & 0xff];
+
+    return crc;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+DeltaPrivate::Encoder::Encoder(const ByteArray& source, const ByteArray& target)
+    : m_source(source),
+      m_target(target),
+      m_head(1 << HashBits, -1),
+      m_previous(source.size(), -1)
+{
+    for (size_t i = 0; i + KeySize <= source.size(); ++i)
+    {
+        const uint32_t key = hash(&source[i]);
+
+        m_previous[i] = m_head[key];
+        m_head[key] = static_cast<int32_t>(i);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto DeltaPrivate::Encoder::encode() -> ByteArray
+{
+    size_t position = 0;
+    size_t literalStart = 0;
+    ptrdiff_t offset = 0; // Source relative to target position of the previous copy
+
+    while (position < m_target.size())
+    {
+        size_t bestSource = 0;
+        size_t bestLength = 0;
+
+        const auto consider = [&](size_t source) {
+            const size_t length = matchLength(source, position);
+
+            // Copies from behind may have been overwritten on the device, so prefer the others
+            const bool safer = (source >= position) && (bestSource < position);
+            const bool better = (length > bestLength) || (length == bestLength && safer);
+            if (better)
+            {
+                bestSource = source;
+                bestLength = length;
+            }
+        };
+
+        const ptrdiff_t shifted = static_cast<ptrdiff_t>(position) + offset;
+
+        if (shifted >= 0 && static_cast<size_t>(shifted) < m_source.size())
+            consider(shifted);
+
+        if (position + KeySize <= m_target.size())
+        {
+            int32_t candidate = m_head[hash(&m_target[position])];
+
+            for (size_t i = 0; candidate >= 0 && i < MaximumChainLength; ++i)
+            {
+                consider(candidate);
+                candidate = m_previous[candidate];
+            }
+        }
+
+        if (bestLength < MinimumCopyLength)
+        {
+            ++position;
+            continue;
+        }
+
+        insert(literalStart, position);
+        copy(bestSource, bestLength);
+
+        offset = static_cast<ptrdiff_t>(bestSource) - static_cast<ptrdiff_t>(position);
+        position += bestLength;
+        literalStart = position;
+    }
+
+    insert(literalStart, position);
+
+    return std::move(m_operations);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto DeltaPrivate::Encoder::matchLength(size_t source, size_t target) const -> size_t
+{
+    const size_t limit = std::min(m_source.size() - source, m_target.size() - target);
+    size_t length = 0;
+
+    while (length < limit && m_source[source + length] == m_target[target + length])
+        ++length;
+
+    return length;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void DeltaPrivate::Encoder::copy(size_t source, size_t length)
+{
+    while (length > 0)
+    {
+        const size_t count = std::min(length, MaximumCopyLength);
+
+        m_operations.push_back(CopyCode);
+        appendLittleEndian(&m_operations, source, 4);
+        appendLittleEndian(&m_operations, count, 2);
+
+        source += count;
+        length -= count;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void DeltaPrivate::Encoder::insert(size_t first, size_t last)
+{
+    while (first < last)
+    {
+        const size_t count = std::min(last - first, MaximumInsertLength);
+
+        m_operations.push_back(static_cast<uint8_t>(count));
+        m_operations.insert(m_operations.end(), m_target.begin() + first,
+                            m_target.begin() + first + count);
+        first += count;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto DeltaPrivate::hash(const uint8_t* bytes) -> uint32_t
+{
+    uint64_t key = 0;
+
+    for (size_t i = 0; i < KeySize; ++i)
+        key = (key << 8) | bytes[i];
+
+    return static_cast<uint32_t>((key * 0x9e3779b97f4a7c15) >> (64 - HashBits));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto DeltaPrivate::parseHexByte(const std::string& line, size_t index) -> uint8_t
+{
+    const auto digit = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+
+    const int high = digit(line[index]);
+    const int low = digit(line[index + 1]);
+
+    if (high < 0 || low < 0)
+        throw Error("Invalid character in hex file.");
+
+    return static_cast<uint8_t>((high << 4) | low);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void DeltaPrivate::appendLittleEndian(ByteArray* bytes, uint32_t value, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        bytes->push_back(static_cast<uint8_t>(value >> (i*8)));
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,62 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF Firmware Updater software.                                       //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2020 - 2024                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Delta updates from a previous firmware version, applied in place by the bootloader. A delta
+// file starts with four little-endian 32-bit values:
+//
+//   source length, source CRC-32, target length, target CRC-32
+//
+// followed by the operations building the target, in the format of the bootloader's Patcher:
+//
+//   Copy:   0x80, source offset (4), length (2)
+//   Insert: length (1 - 127), literal bytes
+//
+// Images are taken from the lowest address of their hex file up to the highest one, with gaps
+// filled as erased flash. The updater knows the device's sectors and replaces copies that can't
+// be applied in place by literal data from the firmware image.
+
+namespace Delta {
+
+    using ByteArray = std::vector<uint8_t>;
+    using Error = std::runtime_error;
+
+    struct Image
+    {
+        uint32_t address;
+        ByteArray data;
+    };
+
+    auto parseHexFile(const std::string& text) -> Image;
+
+    auto create(const Image& source, const Image& target) -> ByteArray;
+
+    // Reflected CRC-32 without inversion, as computed by the bootloader
+    auto checksum(const ByteArray& data) -> uint32_t;
+}
@@ -52,6 +52,7 @@ MainWindow::MainWindow(QWidget* parent)
 
     int size = 2 * QApplication::font().pointSize();
     m_ui->selectHexFile->setIconSize(QSize(size, size));
+    m_ui->selectBaseHexFile->setIconSize(QSize(size, size));
     m_ui->selectMetadataFile->setIconSize(QSize(size, size));
     m_ui->selectSigningKey->setIconSize(QSize(size, size));
     m_ui->updateReleaseDate->setIconSize(QSize(size, size));
@@ -59,6 +60,7 @@ MainWindow::MainWindow(QWidget* parent)
 
     size = m_ui->hexFile->height();
     m_ui->selectHexFile->setMaximumSize(QSize(size, size));
+    m_ui->selectBaseHexFile->setMaximumSize(QSize(size, size));
     m_ui->selectMetadataFile->setMaximumSize(QSize(size, size));
     m_ui->selectSigningKey->setMaximumSize(QSize(size, size));
     m_ui->updateReleaseDate->setMaximumSize(QSize(size, size));
@@ -77,6 +79,8 @@ MainWindow::MainWindow(QWidget* parent)
 
     connect(m_ui->selectHexFile, &QToolButton::clicked,
             this, &MainWindow::selectHexFile);
+    connect(m_ui->selectBaseHexFile, &QToolButton::clicked,
+            this, &MainWindow::selectBaseHexFile);
     connect(m_ui->selectMetadataFile, &QToolButton::clicked,
             this, &MainWindow::selectMetadataFile);
     connect(m_ui->selectSigningKey, &QToolButton::clicked,
@@ -88,6 +92,8 @@ MainWindow::MainWindow(QWidget* parent)
 
     connect(m_ui->hexFile, &QLineEdit::textChanged,
             this, &MainWindow::updateContinueToMetadataButton);
+    connect(m_ui->baseHexFile, &QLineEdit::textChanged,
+            this, &MainWindow::updateContinueToMetadataButton);
     connect(m_ui->metadataFile, &QLineEdit::textChanged,
             this, &MainWindow::updateContinueToMetadataButton);
     connect(m_ui->signingKey, &QLineEdit::textChanged,
@@ -112,6 +118,7 @@ MainWindow::MainWindow(QWidget* parent)
     connect(m_presetsMenu, &PresetsMenu::deleteRequested, this, &MainWindow::deletePreset);
 
     connect(m_ui->hexFile, &QLineEdit::textEdited, m_presetsMenu, &PresetsMenu::setModified);
+    connect(m_ui->baseHexFile, &QLineEdit::textEdited, m_presetsMenu, &PresetsMenu::setModified);
     connect(m_ui->metadataFile, &QLineEdit::textEdited, m_presetsMenu, &PresetsMenu::setModified);
     connect(m_ui->signingKey, &QLineEdit::textEdited, m_presetsMenu, &PresetsMenu::setModified);
 
@@ -150,6 +157,23 @@ void MainWindow::selectHexFile()
 
 // ---------------------------------------------------------------------------------------------- //
 
+void MainWindow::selectBaseHexFile()
+{
+    const QString filename = QFileDialog::getOpenFileName(this, "Select Base HEX File",
+                                                          m_ui->baseHexFile->text(),
+                                                          "HEX Files (*.hex)");
+    if (filename.isEmpty())
+        return;
+
+    if (filename != m_ui->baseHexFile->text())
+    {
+        m_ui->baseHexFile->setText(filename);
+        m_presetsMenu->setModified();
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void MainWindow::selectMetadataFile()
 {
     const QString filename = QFileDialog::getOpenFileName(this, "Select METADATA File",
@@ -212,6 +236,7 @@ void MainWindow::loadPreset(const QString& name)
     settings.beginGroup(name);
 
     m_ui->hexFile->setText(settings.value("HexFile").toString());    
+    m_ui->baseHexFile->setText(settings.value("BaseHexFile").toString());
     m_ui->metadataFile->setText(settings.value("MetadataFile").toString());
     m_ui->signingKey->setText(settings.value("SigningKey").toString());
 }
@@ -241,6 +266,7 @@ void MainWindow::savePreset()
     }
 
     settings.setValue("HexFile", m_ui->hexFile->text());
+    settings.setValue("BaseHexFile", m_ui->baseHexFile->text());
     settings.setValue("MetadataFile", m_ui->metadataFile->text());
     settings.setValue("SigningKey", m_ui->signingKey->text());
 
@@ -393,7 +419,7 @@ void MainWindow::createPackage()
     }
 
     try {
-        Packager::create(m_ui->hexFile->text(), metadata,
+        Packager::create(m_ui->hexFile->text(), m_ui->baseHexFile->text(), metadata,
                          m_ui->signingKey->text(), getPassword,
                          m_ui->outputDirectory->text(), options);
 
@@ -411,10 +437,12 @@ void MainWindow::createPackage()
 void MainWindow::updateContinueToMetadataButton()
 {
     const QString hexFile = m_ui->hexFile->text();
+    const QString baseHexFile = m_ui->baseHexFile->text();
     const QString metadataFile = m_ui->metadataFile->text();
     const QString signingKey = m_ui->signingKey->text();
 
     const bool enable = (!textEmpty(hexFile)      && QFile::exists(hexFile))      &&
+                        ( textEmpty(baseHexFile)  || QFile::exists(baseHexFile))  &&
                         ( textEmpty(metadataFile) || QFile::exists(metadataFile)) &&
                         (!textEmpty(signingKey)   && QFile::exists(signingKey));
 
@@ -467,6 +495,7 @@ void MainWindow::saveSettings()
     QSettings settings;
 
     settings.setValue("HexFile", m_ui->hexFile->text());
+    settings.setValue("BaseHexFile", m_ui->baseHexFile->text());
     settings.setValue("MetadataFile", m_ui->metadataFile->text());
     settings.setValue("SigningKey", m_ui->signingKey->text());
     settings.setValue("BoardName", m_ui->boardName->text());
@@ -492,6 +521,9 @@ void MainWindow::restoreSettings()
     text = settings.value("HexFile", m_ui->hexFile->text()).toString();
     m_ui->hexFile->setText(text);
 
+    text = settings.value("BaseHexFile", m_ui->baseHexFile->text()).toString();
+    m_ui->baseHexFile->setText(text);
+
     text = settings.value("MetadataFile", m_ui->metadataFile->text()).toString();
     m_ui->metadataFile->setText(text);
 
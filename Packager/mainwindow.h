@@ -43,6 +43,7 @@ public:
 
 private slots:
     void selectHexFile();
+    void selectBaseHexFile();
     void selectMetadataFile();
     void selectSigningKey();
     void selectOutputDirectory();
@@ -21,6 +21,7 @@
 //                                                                                                //
 // ============================================================================================== //
 
+#include "delta.h"
 #include "packager.h"
 
 #include <openssl/evp.h>
@@ -45,7 +46,9 @@ namespace PackagerPrivate {
 
     auto openZipFile(const QString& filename) -> zip*;
     void addFileToArchive(zip_t* handle, const QString& filename);
-    void createDataArchive(const QString& path);
+    void createDataArchive(const QString& path, bool includeDelta);
+
+    auto readHexFile(const QString& filename) -> Delta::Image;
 
     int passwordCallback(char* buffer, int size, int rwflag, void* userData);
     void signDataArchive(const QString& path, const QString& signingKey,
@@ -81,7 +84,8 @@ auto Packager::getOutputFileName(const Metadata& metadata, const Options& option
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Packager::create(const QString& hexFile, const Metadata& metadata,
+void Packager::create(const QString& hexFile, const QString& baseHexFile,
+                      const Metadata& metadata,
                       const QString& signingKey, std::function<QString()> password,
                       const QString& outputDirectory, const Options& options)
 {
@@ -95,7 +99,12 @@ void Packager::create(const QString& hexFile, const Metadata& metadata,
     QFile::copy(hexFile, path + "Data.hex");
     writeMetadata(metadata, path + "METADATA");
 
-    createDataArchive(path);
+    const bool includeDelta = !baseHexFile.isEmpty();
+
+    if (includeDelta)
+        writeDelta(hexFile, baseHexFile, path + "Data.delta");
+
+    createDataArchive(path, includeDelta);
     signDataArchive(path, signingKey, std::move(password));
     createPackage(path, metadata, outputDirectory, options);
 }
@@ -120,6 +129,25 @@ void Packager::writeMetadata(const Metadata& metadata, const QString& filename)
 
 // ---------------------------------------------------------------------------------------------- //
 
+// Part of the signed data, so devices only apply deltas from trusted packagers
+void Packager::writeDelta(const QString& hexFile, const QString& baseHexFile,
+                          const QString& filename)
+{
+    const Delta::ByteArray delta = Delta::create(readHexFile(baseHexFile), readHexFile(hexFile));
+
+    QFile file(filename);
+
+    if (!file.open(QFile::WriteOnly))
+        throw Error("Unable to open temporary delta file for writing.");
+
+    const auto size = static_cast<qint64>(delta.size());
+
+    if (file.write(reinterpret_cast<const char*>(delta.data()), size) != size)
+        throw Error("Unable to write temporary delta file.");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 auto PackagerPrivate::openZipFile(const QString& filename) -> zip*
 {
     int error = 0;
@@ -152,13 +180,29 @@ void PackagerPrivate::addFileToArchive(zip_t* handle, const QString& filename)
 
 // ---------------------------------------------------------------------------------------------- //
 
-void PackagerPrivate::createDataArchive(const QString& path)
+void PackagerPrivate::createDataArchive(const QString& path, bool includeDelta)
 {
     zip_t* handle = openZipFile(path + "Data.zip");
     ZipGuard guard(handle, zip_close);
 
     addFileToArchive(handle, path + "Data.hex");
     addFileToArchive(handle, path + "METADATA");
+
+    if (includeDelta)
+        addFileToArchive(handle, path + "Data.delta");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PackagerPrivate::readHexFile(const QString& filename) -> Delta::Image
+{
+    QFile file(filename);
+
+    if (!file.open(QFile::ReadOnly))
+        throw Error("Unable to open HEX file " + QFileInfo(filename).fileName().toStdString()
+                    + " for reading.");
+
+    return Delta::parseHexFile(file.readAll().toStdString());
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -43,10 +43,14 @@ public:
 public:
     static auto getOutputFileName(const Metadata& metadata, const Options& options) -> QString;
 
-    static void create(const QString& hexFile, const Metadata& metadata,
+    // A delta update from the base version is included if a base file is given
+    static void create(const QString& hexFile, const QString& baseHexFile,
+                       const Metadata& metadata,
                        const QString& signingKey, std::function<QString()> password,
                        const QString& outputDirectory, const Options& options);
 
 private:
     static void writeMetadata(const Metadata& metadata, const QString& filename);
+    static void writeDelta(const QString& hexFile, const QString& baseHexFile,
+                           const QString& filename);
 };